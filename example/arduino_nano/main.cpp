@@ -2,84 +2,43 @@
   Author: sascha_lammers@gmx.de
 */
 
-// I2C master
+// USB to I2C bridge
 // Flash on an Arduino Nano, add a 16x2 LCD to the I2C bus (or any other device) and run the windows app
+//
+// build flags: -DSERIALTWOWIRE_NO_GLOBALS -DI2C_OVER_UART_ENABLE_BRIDGE=1 -DI2C_OVER_UART_ENABLE_COMMAND_HANDLERS=1
+//
+// +PING is answered with +PONG and +I2CS scans the I2C bus
 
 #include <Arduino.h>
-#include <SerialTwoWire.h>
+#include <Wire.h>
+#include <SerialTwoWireBridge.h>
 
-void scan_i2c_bus();
-uint8_t *parse_data(const char *data, size_t hex_length, size_t &length);
+SerialTwoWireBridge bridge(Serial, Wire);
+
+void ping(int length);
+void scan_i2c_bus(int length);
 
 void setup()
 {
     Serial.begin(115200);
-#if I2C_OVER_UART_ENABLE_MASTER
     Wire.begin();
-#else
-    Wire.begin(0x01);
-#endif
+    bridge.begin();
+    bridge.addCommandHandler("+PING", ping);
+    bridge.addCommandHandler("+I2CS", scan_i2c_bus);
     Serial.println(F("+PING"));
 }
 
-String line;
-
 void loop()
 {
-    if (Serial.available()) {
-        char tmp = Serial.read();
-        if (tmp == '\n') {
-            size_t length = 0;
-            uint8_t *data = nullptr;
-            if (strcasecmp_P(line.c_str(), PSTR("+PING")) == 0) { // return pong
-                Serial.println(F("+PONG"));
-            }
-            else if (strcasecmp_P(line.c_str(), PSTR("+I2CS")) == 0) { // scan
-                scan_i2c_bus();
-            }
-            else if (strncasecmp_P(line.c_str(), PSTR("+I2CT="), 6) == 0) {     // transmit to Wire from Serial
-                auto data = parse_data(line.c_str() + 6, line.length() - 6, length);
-                if (data && length) {
-                    Wire.beginTransmission(*data);
-                    Wire.write(data, length - 1);
-                    Wire.endTransmission();
-                    // auto result = Wire.endTransmission();
-                    // Serial.print(F("+I2CE="));
-                    // Serial.println(result);
-                }
-            } else if (strncasecmp_P(line.c_str(), PSTR("+I2CR="), 6) == 0) {   /// request from Wire and transmit to Serial
-                auto data = parse_data(line.c_str() + 6, line.length() - 6, length);
-                if (data && length >= 2) {
-                    char buf[4];
-                    uint8_t request_length = *(data + 1);
-                    Serial.print(F("+I2CT="));
-                    snprintf_P(buf, sizeof(buf) - 1, PSTR("%02x"), *data);
-                    Serial.print(buf);
-#if I2C_OVER_UART_ENABLE_MASTER
-                    if (Wire.requestFrom(*data, request_length) == request_length) {
-                        while(Wire.available()) {
-                            snprintf_P(buf, sizeof(buf) - 1, PSTR("%02x"), Wire.read());
-                            Serial.print(buf);
-                        }
-                    }
-#endif
-                    Serial.println();
-                }
-            }
-            if (data) {
-                free(data);
-            }
-            line = String();
-        }
-        else if (tmp == '\r') {
-        }
-        else if (line.length() > 0 || !isspace(tmp)) {
-            line += tmp;
-        }
-    }
+    bridge.poll();
+}
+
+void ping(int length)
+{
+    Serial.println(F("+PONG"));
 }
 
-void scan_i2c_bus()
+void scan_i2c_bus(int length)
 {
     byte error, address;
     int nDevices;
@@ -114,47 +73,3 @@ void scan_i2c_bus()
     else
         Serial.println("done");
 }
-
-uint8_t *parse_data(const char *data, size_t hex_length, size_t &length)
-{
-    length = 0;
-    size_t buffer_size = hex_length / 2 + 2;
-    auto buffer = (uint8_t *)malloc(buffer_size);
-    auto ptr = buffer;
-#define DEBUG_PARSE_DATA 0
-#if DEBUG_PARSE_DATA
-    Serial.print("parse ");
-    Serial.print(hex_length);
-    Serial.print(' ');
-#endif
-    if (buffer) {
-        int pos = 0;
-        while(hex_length--) {
-            pos++;
-            if (*data == ',') {
-                pos = 0;
-            }
-            if (pos == 2) {
-                char buf[3] = {*(data - 1), *(data), 0};
-                *ptr++ = strtoul(buf, nullptr, 16);
-                length++;
-                if (length >= buffer_size) {
-                    break;
-                }
-                pos = 0;
-#if DEBUG_PARSE_DATA
-                Serial.print("0x");
-                Serial.print((int)*(ptr - 1), 16);
-                if (hex_length) {
-                    Serial.print(',');
-                }
-#endif
-            }
-            data++;
-        }
-    }
-#if DEBUG_PARSE_DATA
-    Serial.println();
-#endif
-    return buffer;
-}
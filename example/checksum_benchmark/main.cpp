@@ -0,0 +1,47 @@
+/**
+  Author: sascha_lammers@gmx.de
+*/
+
+// Measures the time per byte of each checksum policy on the target
+// The results are printed on the serial port every 5 seconds and help to select I2C_OVER_UART_CHECKSUM
+
+#include <Arduino.h>
+#include <SerialTwoWireChecksum.h>
+
+static constexpr uint8_t kRounds = 16;
+
+static uint8_t data[128];
+
+template<typename _Ta>
+void benchmark(const __FlashStringHelper *name)
+{
+    volatile typename _Ta::value_type crc;
+    uint32_t start = micros();
+    for(uint8_t i = 0; i < kRounds; i++) {
+        crc = SerialTwoWireChecksum::calculate<_Ta>(data, sizeof(data));
+    }
+    uint32_t duration = micros() - start;
+    (void)crc;
+    Serial.print(name);
+    Serial.print(F(": "));
+    Serial.print(duration * 1000UL / (kRounds * sizeof(data)));
+    Serial.println(F(" ns/byte"));
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    for(auto &byte: data) {
+        byte = random(256);
+    }
+}
+
+void loop()
+{
+    benchmark<SerialTwoWireChecksum::Crc16>(F("CRC16"));
+    benchmark<SerialTwoWireChecksum::Crc16Table>(F("CRC16_TABLE"));
+    benchmark<SerialTwoWireChecksum::Crc8>(F("CRC8"));
+    benchmark<SerialTwoWireChecksum::Fletcher16>(F("FLETCHER16"));
+    Serial.println();
+    delay(5000);
+}
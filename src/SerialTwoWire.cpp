@@ -17,6 +17,9 @@ SerialTwoWire Wire;
 
 void serialEvent()
 {
+#if I2C_OVER_UART_ENABLE_RX_RING
+    Wire.feed();
+#endif
     auto &serial = Wire.getSerial();
     while (serial.available()) {
         Wire.feed(serial.read());
@@ -0,0 +1,631 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWire.h"
+#include "SerialTwoWireBridge.h"
+#include "SerialTwoWireDebug.h"
+
+#if I2C_OVER_UART_ENABLE_BRIDGE
+
+#include <Wire.h>
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+SerialTwoWireBridge::SerialTwoWireBridge(Stream &serial, TwoWire &wire) :
+    SerialTwoWireSlave(serial, nullptr),
+    _wire(&wire),
+    _fill(0)
+{
+    for(auto &transaction: _transactions) {
+        transaction._command = CommandType::NONE;
+    }
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+    for(auto &program: _programs) {
+        program._length = 0;
+    }
+#endif
+    _in.setBuffer(_transactions[0]._data, kBufferSize);
+    _out.setBuffer(_outBuffer, kOutBufferSize);
+}
+
+void SerialTwoWireBridge::begin()
+{
+    __LDBG_assertf(data()._address == kNotInitializedAddress, "begin called again without end");
+    data()._address = kMasterAddress;
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    _retransmit.begin();
+#endif
+}
+
+void SerialTwoWireBridge::end()
+{
+    _end();
+    for(auto &transaction: _transactions) {
+        transaction._command = CommandType::NONE;
+    }
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+    for(auto &program: _programs) {
+        program._length = 0;
+    }
+#endif
+    _fill = 0;
+    _in.setBuffer(_transactions[0]._data, kBufferSize);
+}
+
+void SerialTwoWireBridge::poll()
+{
+    // decode the next command before waiting for the bus
+#if I2C_OVER_UART_ENABLE_RX_RING
+    feed();
+#endif
+    while (_serial->available()) {
+        feed(_serial->read());
+    }
+    auto &pending = _pending();
+    if (pending._command != CommandType::NONE) {
+        _execute(pending);
+    }
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+    for(uint8_t slot = 0; slot < kProgramSlots; slot++) {
+        auto &program = _programs[slot];
+        if (program._length && program._interval && (uint32_t)(millis() - program._lastRun) >= program._interval) {
+            // the pending transaction buffer is free and used for the results
+            _runProgram(slot, pending._data);
+        }
+    }
+#endif
+    SerialTwoWireSlave::poll();
+}
+
+void SerialTwoWireBridge::feed(uint8_t byte)
+{
+#if I2C_OVER_UART_ENABLE_RESYNC
+    _resync(byte);
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    _flowLineLength++;
+#endif
+    if (byte == '\n') { // check first
+        _newLine();
+    }
+    else if (flags()._getCommand() == CommandType::DISCARD || byte == '\r') {
+        // skip rest of the line cause of invalid data
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+        _forwardUnknownLine(byte);
+#endif
+    }
+    else if (flags()._getCommand() == CommandType::NONE) {
+        if ((data()._length == 0 && byte != '+') || data()._length >= kCommandMaxLength) {
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+            _beginUnknownLine(byte);
+#endif
+            data()._length = 0;
+            _discard();
+        }
+        else {
+            // append
+            _buffer[data()._length++] = byte;
+            _buffer[data()._length] = 0;
+            switch(getCommandStringType(_buffer)) {
+                case CommandStringType::MASTER_TRANSMIT:
+                    flags()._setCommand(CommandType::MASTER_TRANSMIT);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+                case CommandStringType::MASTER_REQUEST:
+                    flags()._setCommand(CommandType::MASTER_REQUEST);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+                case CommandStringType::COMPRESSED_TRANSMIT:
+                    flags()._setCommand(CommandType::MASTER_TRANSMIT);
+                    data()._length = 0;
+                    _newTransmission();
+                    _beginCompressed();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+                case CommandStringType::SEQUENCED_TRANSMIT:
+                    flags()._setCommand(CommandType::MASTER_TRANSMIT);
+                    flags()._sequenced = true;
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+                case CommandStringType::ACKNOWLEDGE:
+                    flags()._setCommand(CommandType::ACKNOWLEDGE);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+                case CommandStringType::FLOW_CONTROL:
+                    flags()._setCommand(CommandType::FLOW_CONTROL);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+                case CommandStringType::NEGOTIATE:
+                    flags()._setCommand(CommandType::NEGOTIATE);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+                case CommandStringType::PROGRAM:
+                    flags()._setCommand(CommandType::PROGRAM);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+                case CommandStringType::RUN_PROGRAM:
+                    flags()._setCommand(CommandType::RUN_PROGRAM);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+                case CommandStringType::MULTI_READ:
+                    flags()._setCommand(CommandType::MULTI_READ);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+                default:
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+                    _findCommandHandler();
+#endif
+                    break;
+            }
+        }
+    }
+#if I2C_OVER_UART_ADD_CRC16
+    else if (byte == kCrcStartChar && !flags()._crcMarker) {
+        flags()._crcMarker = true;
+    }
+#endif
+    else if (isxdigit(byte)) {
+        // add data to command buffer
+        _buffer[data()._length++] = byte;
+        _addBuffer(_parseData());
+    }
+    else if (byte != ',' && !isspace(byte)) {
+#if I2C_OVER_UART_ENABLE_FEC
+        // probably a corrupted digit, replace it and let the FEC correct the byte
+        __LDBG_printf("replace data=%u", byte);
+        _buffer[data()._length++] = '0';
+        _addBuffer(_parseData());
+#else
+        // invalid data, discard
+        __LDBG_printf("discard data=%u", byte);
+        _discard();
+#endif
+    }
+}
+
+void SerialTwoWireBridge::_newLine()
+{
+    // add any data left in the buffer
+    _addBuffer(_parseData(true));
+#if I2C_OVER_UART_ENABLE_FEC
+    if (_fecCorrect()) {
+        for(uint8_t i = 0; i < _fecLength && flags()._getCommand() > CommandType::DISCARD; i++) {
+            _addBuffer(_fecBuffer[i]);
+        }
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+    if (flags()._compressed && !_decoder.isComplete()) {
+        __LDBG_printf("discard incomplete compressed data ilen=%u", _in.length());
+        _discard();
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    if (flags()._sequenced && flags()._getCommand() > CommandType::DISCARD && flags()._inState) {
+        // the address is stored in _in
+        _receiveSequenced(1);
+    }
+#endif
+
+    __LDBG_printf("cmd=%s ilen=%u", flags()._getCommandAsString().c_str(), _in.length());
+    if (flags()._getCommand() > CommandType::DISCARD && flags()._inState) {
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+        _commitBaudRate();
+#endif
+        switch(flags()._getCommand()) {
+        case CommandType::MASTER_TRANSMIT:
+        case CommandType::MASTER_REQUEST:
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+        case CommandType::PROGRAM:
+        case CommandType::RUN_PROGRAM:
+#endif
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+        case CommandType::MULTI_READ:
+#endif
+            _queue();
+            break;
+        default:
+            flags()._processing = true;
+            _processData();
+            flags()._processing = false;
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+            // apply the clock requested with setClock()
+            if (flags()._getCommand() == CommandType::NEGOTIATE && _in.length() > 1 && static_cast<NegotiationType>(_in[1]) == NegotiationType::REQUEST && _peer._clock) {
+                _wire->setClock(_peer._clock);
+            }
+#endif
+            break;
+        }
+    }
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    _flowNewLine();
+#endif
+    _cleanup();
+}
+
+void SerialTwoWireBridge::_addBuffer(int byte)
+{
+    if (byte == kNoDataAvailable) {
+        return;
+    }
+    // the first byte is the address, transmissions are accepted for any address
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+    if (flags()._compressed && _in.length()) {
+        _addCompressed(byte, kBufferSize);
+    }
+    else
+#endif
+    if (_in.length() >= kBufferSize) {
+        __LDBG_printf("data=%u ilen=%u max=%u", byte, _in.length(), kBufferSize);
+        _discard();
+    }
+    else {
+        _in.write(byte);
+        flags()._inState = true;
+    }
+    data()._length = 0;
+}
+
+void SerialTwoWireBridge::_queue()
+{
+    // the previous transaction must be completed first
+    auto &pending = _pending();
+    if (pending._command != CommandType::NONE) {
+        _execute(pending);
+    }
+    auto &current = _transactions[_fill];
+    current._command = flags()._getCommand();
+    current._length = _in.length();
+    // decode the next command into the other buffer
+    _fill ^= 1;
+    _in.setBuffer(pending._data, kBufferSize);
+}
+
+void SerialTwoWireBridge::_execute(Transaction_t &transaction)
+{
+    auto address = transaction._data[0];
+    switch(transaction._command) {
+    case CommandType::MASTER_TRANSMIT:
+        _stats._transmissions++;
+        _wire->beginTransmission(address);
+        _wire->write(&transaction._data[1], transaction._length - 1);
+        if (_wire->endTransmission() != 0) {
+            __LDBG_printf("addr=%02x len=%u failed", address, transaction._length - 1);
+            _stats._errors++;
+        }
+        break;
+    case CommandType::MASTER_REQUEST:
+        _stats._requests++;
+        if (transaction._length == 2) {
+            _sendResponse(address, transaction._data[1]);
+        }
+        else {
+            __LDBG_printf("addr=%02x len=%u", address, transaction._length);
+            _sendNack(address);
+        }
+        break;
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+    case CommandType::MULTI_READ:
+        _stats._requests++;
+        _sendMultiReadResponse(transaction);
+        break;
+#endif
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+    case CommandType::PROGRAM:
+        _storeProgram(transaction);
+        break;
+    case CommandType::RUN_PROGRAM:
+        // slot and optional interval
+        if (address >= kProgramSlots) {
+            __LDBG_printf("slot=%u invalid", address);
+            break;
+        }
+        if (transaction._length == 3) {
+            _programs[address]._interval = (transaction._data[1] << 8) | transaction._data[2];
+            if (!_programs[address]._interval) {
+                // stop only
+                break;
+            }
+        }
+        if (transaction._length != 1 && transaction._length != 3) {
+            _sendProgramResult(address, static_cast<uint8_t>(EndTransmissionCode::OTHER), nullptr, 0);
+        }
+        else if (!_programs[address]._length) {
+            _sendProgramResult(address, static_cast<uint8_t>(EndTransmissionCode::INVALID_ADDRESS), nullptr, 0);
+        }
+        else {
+            // the transaction buffer is used for the results
+            _runProgram(address, transaction._data);
+        }
+        break;
+#endif
+    default:
+        break;
+    }
+    transaction._command = CommandType::NONE;
+}
+
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+
+uint16_t SerialTwoWireBridge::_getInstructionLength(const uint8_t *code, uint16_t pc, uint8_t length)
+{
+    switch(static_cast<ProgramOpcode>(code[pc])) {
+    case ProgramOpcode::WRITE:
+        // the length of the data is the 3rd byte
+        return (pc + 2 < length) ? 3 + code[pc + 2] : 3;
+    case ProgramOpcode::READ:
+    case ProgramOpcode::DELAY:
+        return 3;
+    case ProgramOpcode::JUMP_IF_NACK:
+        return 2;
+    case ProgramOpcode::END:
+        return 1;
+    default:
+        break;
+    }
+    return 0;
+}
+
+void SerialTwoWireBridge::_storeProgram(const Transaction_t &transaction)
+{
+    auto slot = transaction._data[0];
+    if (slot >= kProgramSlots) {
+        return;
+    }
+    auto &program = _programs[slot];
+    program._length = 0;
+    program._interval = 0;
+    auto code = &transaction._data[1];
+    uint8_t length = transaction._length - 1;
+    if (length > kProgramMaxLength) {
+        __LDBG_printf("slot=%u len=%u max=%u", slot, length, kProgramMaxLength);
+        return;
+    }
+    // verify the operands of each instruction, that the results of all reads fit into the
+    // transaction buffer and that jumps land on an instruction or the end of the program
+    uint8_t boundaries[(kProgramMaxLength + 8) / 8] = {};
+    uint16_t results = 0;
+    uint16_t pc;
+    for(pc = 0; pc < length; ) {
+        boundaries[pc / 8] |= (1 << (pc % 8));
+        auto size = _getInstructionLength(code, pc, length);
+        if (size == 0 || pc + size > length) {
+            __LDBG_printf("slot=%u invalid opcode=%02x pc=%u len=%u", slot, code[pc], pc, length);
+            return;
+        }
+        if (static_cast<ProgramOpcode>(code[pc]) == ProgramOpcode::READ) {
+            results += code[pc + 2];
+            if (results > kBufferSize) {
+                __LDBG_printf("slot=%u pc=%u results=%u", slot, pc, results);
+                return;
+            }
+        }
+        pc += size;
+    }
+    boundaries[length / 8] |= (1 << (length % 8));
+    for(pc = 0; pc < length; pc += _getInstructionLength(code, pc, length)) {
+        if (static_cast<ProgramOpcode>(code[pc]) == ProgramOpcode::JUMP_IF_NACK) {
+            uint16_t target = pc + 2 + code[pc + 1];
+            if (target > length || !(boundaries[target / 8] & (1 << (target % 8)))) {
+                __LDBG_printf("slot=%u pc=%u invalid jump target=%u", slot, pc, target);
+                return;
+            }
+        }
+    }
+    memcpy(program._code, code, length);
+    program._length = length;
+    program._results = results;
+}
+
+void SerialTwoWireBridge::_runProgram(uint8_t slot, uint8_t *results)
+{
+    auto &program = _programs[slot];
+    auto code = program._code;
+    uint8_t status = 0;
+    uint8_t length = 0;
+    bool failed = false;
+    uint8_t steps = 0;
+    program._lastRun = millis();
+    for(uint16_t pc = 0; pc < program._length; ) {
+        // programs are verified when stored, this protects against corrupted slots
+        auto size = _getInstructionLength(code, pc, program._length);
+        auto overflow = static_cast<ProgramOpcode>(code[pc]) == ProgramOpcode::READ && length + code[pc + 2] > kBufferSize;
+        if (size == 0 || pc + size > program._length || overflow || ++steps > kProgramMaxLength) {
+            __LDBG_printf("slot=%u aborted pc=%u steps=%u", slot, pc, steps);
+            if (!status) {
+                status = static_cast<uint8_t>(EndTransmissionCode::OTHER);
+            }
+            break;
+        }
+        switch(static_cast<ProgramOpcode>(code[pc++])) {
+        case ProgramOpcode::WRITE: {
+                auto address = code[pc++];
+                auto count = code[pc++];
+                _wire->beginTransmission(address);
+                _wire->write(&code[pc], count);
+                pc += count;
+                auto result = _wire->endTransmission();
+                failed = (result != 0);
+                if (failed && !status) {
+                    status = result;
+                }
+            } break;
+        case ProgramOpcode::READ: {
+                auto address = code[pc++];
+                auto count = code[pc++];
+                uint8_t received = _wire->requestFrom(address, count);
+                failed = (received != count);
+                if (failed && !status) {
+                    status = static_cast<uint8_t>(EndTransmissionCode::NACK_ON_ADDRESS);
+                }
+                // missing data is filled with zeros
+                for(uint8_t i = 0; i < count; i++) {
+                    results[length++] = i < received ? _wire->read() : 0;
+                }
+            } break;
+        case ProgramOpcode::DELAY: {
+                uint16_t delay = (code[pc] << 8) | code[pc + 1];
+                pc += 2;
+                auto start = millis();
+                while((uint32_t)(millis() - start) < delay) {
+                    optimistic_yield(1000);
+                }
+            } break;
+        case ProgramOpcode::JUMP_IF_NACK: {
+                auto offset = code[pc++];
+                if (failed) {
+                    pc += offset;
+                }
+            } break;
+        default:
+            pc = program._length;
+            break;
+        }
+    }
+    __LDBG_printf("slot=%u status=%u len=%u", slot, status, length);
+    // zeros are appended for skipped and aborted reads, the response has the same length for
+    // each run
+    while(length < program._results) {
+        results[length++] = 0;
+    }
+    _sendProgramResult(slot, status, results, length);
+}
+
+void SerialTwoWireBridge::_sendProgramResult(uint8_t slot, uint8_t status, const uint8_t *results, uint8_t length)
+{
+    uint8_t address = kProgramAddress + slot;
+    _printCommand(CommandStringType::SLAVE_RESPONSE);
+#if I2C_OVER_UART_ADD_CRC16
+    checksum_t crc = Checksum::kInit;
+    _printHexUpdateCrc(address, crc);
+    _printHexUpdateCrc(status, crc);
+    for(uint8_t i = 0; i < length; i++) {
+        _printHexUpdateCrc(results[i], crc);
+    }
+    _printHexCrc(crc);
+#else
+    _printHex(address);
+    _printHex(status);
+    for(uint8_t i = 0; i < length; i++) {
+        _printHex(results[i]);
+    }
+    _println();
+#endif
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+
+void SerialTwoWireBridge::_sendMultiReadResponse(const Transaction_t &transaction)
+{
+    // number of items followed by address, register and length
+    auto count = transaction._data[0];
+    if (transaction._length != 1 + count * 3) {
+        __LDBG_printf("count=%u len=%u", count, transaction._length);
+        _sendNack(kMultiReadAddress);
+        return;
+    }
+    // the status and data of each item is sent as soon as it has been read
+    _printCommand(CommandStringType::SLAVE_RESPONSE);
+#if I2C_OVER_UART_ADD_CRC16
+    checksum_t crc = Checksum::kInit;
+    _printHexUpdateCrc(kMultiReadAddress, crc);
+#else
+    _printHex(kMultiReadAddress);
+#endif
+    auto item = &transaction._data[1];
+    for(uint8_t i = 0; i < count; i++, item += 3) {
+        auto address = item[0];
+        auto length = item[2];
+        _wire->beginTransmission(address);
+        _wire->write(item[1]);
+        uint8_t status = _wire->endTransmission(false);
+        uint8_t received = 0;
+        if (status == 0) {
+            received = _wire->requestFrom(address, length);
+            if (received != length) {
+                status = static_cast<uint8_t>(EndTransmissionCode::NACK_ON_ADDRESS);
+            }
+        }
+        if (status) {
+            _stats._errors++;
+        }
+#if I2C_OVER_UART_ADD_CRC16
+        _printHexUpdateCrc(status, crc);
+#else
+        _printHex(status);
+#endif
+        // missing data is filled with zeros
+        for(uint8_t j = 0; j < length; j++) {
+            uint8_t data = j < received ? _wire->read() : 0;
+#if I2C_OVER_UART_ADD_CRC16
+            _printHexUpdateCrc(data, crc);
+#else
+            _printHex(data);
+#endif
+        }
+    }
+#if I2C_OVER_UART_ADD_CRC16
+    _printHexCrc(crc);
+#else
+    _println();
+#endif
+}
+
+#endif
+
+void SerialTwoWireBridge::_sendResponse(uint8_t address, uint8_t count)
+{
+    uint8_t received = _wire->requestFrom(address, count);
+    if (received != count) {
+        // send address only
+        __LDBG_printf("addr=%02x count=%u received=%u", address, count, received);
+        _stats._errors++;
+        received = 0;
+    }
+    _printCommand(CommandStringType::SLAVE_RESPONSE);
+#if I2C_OVER_UART_ADD_CRC16
+    checksum_t crc = Checksum::kInit;
+    _printHexUpdateCrc(address, crc);
+    while (received--) {
+        _printHexUpdateCrc(_wire->read(), crc);
+    }
+#else
+    _printHex(address);
+    while (received--) {
+        _printHex(_wire->read());
+    }
+#endif
+#if I2C_OVER_UART_ADD_CRC16
+    _printHexCrc(crc);
+#else
+    _println();
+#endif
+}
+
+#endif
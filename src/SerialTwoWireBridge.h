@@ -0,0 +1,121 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+// Bridge between the serial port and a real I2C bus
+//
+// transmissions and requests are decoded into two static buffers. the next command is
+// decoded while the previous one is waiting for the bus and responses are sent directly
+// from the TwoWire buffer. no memory is allocated
+//
+// programs uploaded with +I2CM=<slot><code> run a sequence of ProgramOpcode steps when
+// requested with +I2CX=<slot>[<interval>] and send the results in one response from
+// kProgramAddress + slot: +I2CA=<kProgramAddress + slot><status><data>
+
+#pragma once
+
+#include "SerialTwoWire.h"
+#include "SerialTwoWireDebug.h"
+
+#if I2C_OVER_UART_ENABLE_BRIDGE
+
+#ifndef SERIALTWOWIRE_NO_GLOBALS
+#error SerialTwoWireBridge requires SERIALTWOWIRE_NO_GLOBALS
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+class TwoWire;
+
+class SerialTwoWireBridge : public SerialTwoWireSlave
+{
+public:
+    static constexpr uint8_t kBufferSize = I2C_OVER_UART_BRIDGE_BUFFER_SIZE;
+    // negotiation and flow control frames
+    static constexpr uint8_t kOutBufferSize = 16;
+
+    struct Stats {
+        uint32_t _transmissions;
+        uint32_t _requests;
+        uint32_t _errors;                   // NACK or bus error
+
+        Stats() : _transmissions(0), _requests(0), _errors(0) {}
+    };
+
+public:
+    SerialTwoWireBridge(Stream &serial, TwoWire &wire);
+
+    void begin();
+    void end();
+
+    // reads the serial port, decodes commands and executes them on the I2C bus
+    // must be called inside loop()
+    void poll();
+
+    virtual void feed(uint8_t data) override;
+#if I2C_OVER_UART_ENABLE_RX_RING
+    using SerialTwoWireSlave::feed;
+#endif
+
+    const Stats &getStats() const;
+    void resetStats();
+
+protected:
+    struct Transaction_t {
+        CommandType _command;               // NONE = free
+        uint8_t _length;
+        uint8_t _data[kBufferSize];         // address and data or length
+    };
+
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+    struct Program_t {
+        uint8_t _length;                    // 0 = unused
+        uint8_t _results;                   // length of the data of all reads
+        uint16_t _interval;                 // 0 = run on request only
+        uint32_t _lastRun;
+        uint8_t _code[kProgramMaxLength];
+    };
+#endif
+
+#if I2C_OVER_UART_ENABLE_RESYNC
+    virtual void _newLine() override;
+#else
+    void _newLine();
+#endif
+    void _addBuffer(int data);
+    void _queue();
+    void _execute(Transaction_t &transaction);
+    void _sendResponse(uint8_t address, uint8_t count);
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+    void _sendMultiReadResponse(const Transaction_t &transaction);
+#endif
+    Transaction_t &_pending();
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+    void _storeProgram(const Transaction_t &transaction);
+    void _runProgram(uint8_t slot, uint8_t *results);
+    void _sendProgramResult(uint8_t slot, uint8_t status, const uint8_t *results, uint8_t length);
+    // returns the size of the instruction at pc including its operands or 0 for invalid opcodes
+    static uint16_t _getInstructionLength(const uint8_t *code, uint16_t pc, uint8_t length);
+#endif
+
+protected:
+    TwoWire *_wire;
+    Stats _stats;
+    Transaction_t _transactions[2];
+    uint8_t _fill;                          // index of the transaction being decoded
+    uint8_t _outBuffer[kOutBufferSize];
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+    Program_t _programs[kProgramSlots];
+#endif
+};
+
+#include "SerialTwoWireBridge.hpp"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
+
+#endif
@@ -0,0 +1,31 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireBridge.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+inline const SerialTwoWireBridge::Stats &SerialTwoWireBridge::getStats() const
+{
+    return _stats;
+}
+
+inline void SerialTwoWireBridge::resetStats()
+{
+    _stats = Stats();
+}
+
+inline SerialTwoWireBridge::Transaction_t &SerialTwoWireBridge::_pending()
+{
+    return _transactions[_fill ^ 1];
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
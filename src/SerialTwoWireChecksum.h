@@ -0,0 +1,80 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+
+//
+// Checksum policies
+//
+// each policy has the type of the checksum, the initial value and an update function for a
+// single byte. the checksum is updated while the data is encoded or decoded and sent as
+// sizeof(value_type) * 2 hex digits after kCrcStartChar, most significant byte first
+//
+// the policy is selected with I2C_OVER_UART_CHECKSUM. the cost per byte can be measured
+// on the target with example/checksum_benchmark
+//
+namespace SerialTwoWireChecksum {
+
+    // CRC-16/ARC, polynomial 0xa001 reflected. same as _crc16_update() of avr-libc and
+    // compatible with previous versions
+    struct Crc16 {
+        using value_type = uint16_t;
+        static constexpr value_type kInit = 0xffff;
+
+        static value_type update(value_type crc, uint8_t data);
+    };
+
+    // CRC-16/ARC with a 512 byte lookup table in PROGMEM
+    struct Crc16Table {
+        using value_type = uint16_t;
+        static constexpr value_type kInit = 0xffff;
+
+        static value_type update(value_type crc, uint8_t data);
+    };
+
+    // CRC-8/MAXIM, polynomial 0x8c reflected. same as _crc_ibutton_update() of avr-libc
+    struct Crc8 {
+        using value_type = uint8_t;
+        static constexpr value_type kInit = 0x00;
+
+        static value_type update(value_type crc, uint8_t data);
+    };
+
+    // Fletcher-16, sum2 in the high byte and sum1 in the low byte
+    struct Fletcher16 {
+        using value_type = uint16_t;
+        static constexpr value_type kInit = 0x0000;
+
+        static value_type update(value_type sum, uint8_t data);
+    };
+
+    template<typename _Ta>
+    typename _Ta::value_type calculate(const uint8_t *data, size_t length, typename _Ta::value_type crc = _Ta::kInit);
+
+}
+
+namespace SerialTwoWireDef {
+
+#if I2C_OVER_UART_CHECKSUM == I2C_OVER_UART_CHECKSUM_CRC16
+    using Checksum = SerialTwoWireChecksum::Crc16;
+#elif I2C_OVER_UART_CHECKSUM == I2C_OVER_UART_CHECKSUM_CRC16_TABLE
+    using Checksum = SerialTwoWireChecksum::Crc16Table;
+#elif I2C_OVER_UART_CHECKSUM == I2C_OVER_UART_CHECKSUM_CRC8
+    using Checksum = SerialTwoWireChecksum::Crc8;
+#elif I2C_OVER_UART_CHECKSUM == I2C_OVER_UART_CHECKSUM_FLETCHER16
+    using Checksum = SerialTwoWireChecksum::Fletcher16;
+#else
+#error invalid I2C_OVER_UART_CHECKSUM
+#endif
+
+    using checksum_t = Checksum::value_type;
+
+    // number of hex digits of the checksum
+    static constexpr uint8_t kChecksumLength = sizeof(checksum_t) * 2;
+
+}
+
+#include "SerialTwoWireChecksum.hpp"
@@ -0,0 +1,51 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireChecksum.h"
+
+namespace SerialTwoWireChecksum {
+
+    inline Crc16::value_type Crc16::update(value_type crc, uint8_t data)
+    {
+        crc ^= data;
+        for(uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xa001) : (crc >> 1);
+        }
+        return crc;
+    }
+
+    inline Crc8::value_type Crc8::update(value_type crc, uint8_t data)
+    {
+        crc ^= data;
+        for(uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0x8c) : (crc >> 1);
+        }
+        return crc;
+    }
+
+    inline Fletcher16::value_type Fletcher16::update(value_type sum, uint8_t data)
+    {
+        uint16_t sum1 = (sum & 0xff) + data;
+        if (sum1 >= 255) {
+            sum1 -= 255;
+        }
+        uint16_t sum2 = (sum >> 8) + sum1;
+        if (sum2 >= 255) {
+            sum2 -= 255;
+        }
+        return (sum2 << 8) | sum1;
+    }
+
+    template<typename _Ta>
+    typename _Ta::value_type calculate(const uint8_t *data, size_t length, typename _Ta::value_type crc)
+    {
+        for(auto end = data + length; data != end; ++data) {
+            crc = _Ta::update(crc, *data);
+        }
+        return crc;
+    }
+
+}
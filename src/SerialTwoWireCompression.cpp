@@ -0,0 +1,66 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWireCompression.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+
+bool SerialTwoWireCompression::decode(uint8_t byte, SerialTwoWireStream &out, size_t maxLength)
+{
+    switch(_state) {
+    case StateType::TOKEN:
+        if (byte < 0x80) {
+            _state = StateType::LITERAL;
+            _count = byte + 1;
+        }
+        else {
+            _state = byte < 0xc0 ? StateType::RUN : StateType::REFERENCE;
+            _count = (byte & 0x3f) + kMinMatch;
+        }
+        return true;
+    case StateType::LITERAL:
+        if (out.length() >= maxLength) {
+            break;
+        }
+        out.write(byte);
+        _length++;
+        if (--_count == 0) {
+            _state = StateType::TOKEN;
+        }
+        return true;
+    case StateType::RUN:
+        if (out.length() + _count > maxLength) {
+            break;
+        }
+        _length += _count;
+        while (_count--) {
+            out.write(byte);
+        }
+        _state = StateType::TOKEN;
+        return true;
+    case StateType::REFERENCE: {
+            size_t distance = byte + 1;
+            if (distance > _length || out.length() + _count > maxLength) {
+                break;
+            }
+            _length += _count;
+            while (_count--) {
+                uint8_t data = out[out.length() - distance];
+                out.write(data);
+            }
+            _state = StateType::TOKEN;
+        }
+        return true;
+    }
+    __LDBG_printf("invalid state=%u count=%u len=%u", _state, _count, out.length());
+    return false;
+}
+
+#endif
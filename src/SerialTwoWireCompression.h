@@ -0,0 +1,75 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+#include "SerialTwoWireStream.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+using namespace SerialTwoWireDef;
+
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+
+//
+// Payload compression for +I2CZ
+//
+// the payload is a sequence of tokens
+//
+// 0x00 - 0x7f  <data>          literal, (token + 1) bytes of data follow
+// 0x80 - 0xbf  <byte>          run, byte is repeated (token & 0x3f) + 3 times
+// 0xc0 - 0xff  <distance>      back reference, copy (token & 0x3f) + 3 bytes starting
+//                              distance + 1 bytes before the current position
+//
+// references can overlap the current position. the decoder uses the data decoded so far as
+// window and does not need any additional memory
+//
+class SerialTwoWireCompression {
+public:
+    static constexpr uint8_t kMinMatch = 3;
+    static constexpr uint8_t kMaxMatch = 0x3f + kMinMatch;
+    static constexpr uint8_t kMaxLiterals = 0x80;
+    static constexpr uint16_t kWindow = I2C_OVER_UART_COMPRESSION_WINDOW;
+
+    enum class StateType : uint8_t {
+        TOKEN,
+        LITERAL,
+        RUN,
+        REFERENCE,
+    };
+
+public:
+    SerialTwoWireCompression();
+
+    // compress length bytes of data and pass each byte to output(uint8_t)
+    // returns the length of the compressed data
+    template<typename _Ta>
+    static size_t compress(const uint8_t *data, size_t length, _Ta output);
+
+    void begin();
+    // append decoded data to out. returns false if the data is invalid or maxLength is exceeded
+    bool decode(uint8_t byte, SerialTwoWireStream &out, size_t maxLength);
+    // returns false if the last token is incomplete
+    bool isComplete() const;
+
+private:
+    template<typename _Ta>
+    static void _flushLiterals(const uint8_t *data, size_t count, _Ta &output);
+
+    StateType _state;
+    uint8_t _count;
+    uint8_t _length;                        // bytes decoded
+};
+
+#include "SerialTwoWireCompression.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,102 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireCompression.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+inline SerialTwoWireCompression::SerialTwoWireCompression() : _state(StateType::TOKEN), _count(0), _length(0)
+{
+}
+
+inline void SerialTwoWireCompression::begin()
+{
+    _state = StateType::TOKEN;
+    _length = 0;
+}
+
+inline bool SerialTwoWireCompression::isComplete() const
+{
+    return _state == StateType::TOKEN;
+}
+
+template<typename _Ta>
+size_t SerialTwoWireCompression::compress(const uint8_t *data, size_t length, _Ta output)
+{
+    size_t written = 0;
+    size_t literals = 0;
+    size_t pos = 0;
+    while (pos < length) {
+        auto max = length - pos < kMaxMatch ? length - pos : kMaxMatch;
+        // repeated byte
+        size_t run = 1;
+        while (run < max && data[pos + run] == data[pos]) {
+            run++;
+        }
+        // longest match inside the window
+        size_t match = 0;
+        size_t distance = 0;
+        if (run < max) {
+            for(size_t i = pos > kWindow ? pos - kWindow : 0; i < pos; i++) {
+                size_t n = 0;
+                while (n < max && data[i + n] == data[pos + n]) {
+                    n++;
+                }
+                if (n > match) {
+                    match = n;
+                    distance = pos - i;
+                }
+            }
+        }
+        if (run >= kMinMatch && run >= match) {
+            _flushLiterals(&data[pos - literals], literals, output);
+            written += literals ? literals + 1 : 0;
+            literals = 0;
+            output(0x80 | (run - kMinMatch));
+            output(data[pos]);
+            written += 2;
+            pos += run;
+        }
+        else if (match >= kMinMatch) {
+            _flushLiterals(&data[pos - literals], literals, output);
+            written += literals ? literals + 1 : 0;
+            literals = 0;
+            output(0xc0 | (match - kMinMatch));
+            output(distance - 1);
+            written += 2;
+            pos += match;
+        }
+        else {
+            pos++;
+            if (++literals == kMaxLiterals) {
+                _flushLiterals(&data[pos - literals], literals, output);
+                written += literals + 1;
+                literals = 0;
+            }
+        }
+    }
+    _flushLiterals(&data[pos - literals], literals, output);
+    written += literals ? literals + 1 : 0;
+    return written;
+}
+
+template<typename _Ta>
+void SerialTwoWireCompression::_flushLiterals(const uint8_t *data, size_t count, _Ta &output)
+{
+    if (count) {
+        output(count - 1);
+        while (count--) {
+            output(*data++);
+        }
+    }
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -26,6 +26,16 @@ namespace SerialTwoWireDef {
     #define I2C_OVER_UART_ADD_CRC16                 0
     #endif
 
+    // checksum used with I2C_OVER_UART_ADD_CRC16, see SerialTwoWireChecksum.h. both sides must use the same one
+    #define I2C_OVER_UART_CHECKSUM_CRC16            0       // CRC-16/ARC, no table
+    #define I2C_OVER_UART_CHECKSUM_CRC16_TABLE      1       // CRC-16/ARC, 512 byte table in PROGMEM
+    #define I2C_OVER_UART_CHECKSUM_CRC8             2       // CRC-8/MAXIM, 2 byte less per frame
+    #define I2C_OVER_UART_CHECKSUM_FLETCHER16       3       // fastest without table, weaker than CRC-16
+
+    #ifndef I2C_OVER_UART_CHECKSUM
+    #define I2C_OVER_UART_CHECKSUM                  I2C_OVER_UART_CHECKSUM_CRC16
+    #endif
+
     // needs quite some memory
     #ifndef I2C_OVER_UART_USE_STD_FUNCTION
     #define I2C_OVER_UART_USE_STD_FUNCTION          0
@@ -97,6 +107,448 @@ namespace SerialTwoWireDef {
     #endif
     #endif
 
+    // cache for SerialTwoWireMaster::requestFrom(), see SerialTwoWireReadCache.h
+    // caching is enabled per address with SerialTwoWireMaster::setReadCacheTTL()
+    #ifndef I2C_OVER_UART_ENABLE_READ_CACHE
+    #define I2C_OVER_UART_ENABLE_READ_CACHE         0
+    #endif
+
+    // number of cached responses
+    #ifndef I2C_OVER_UART_READ_CACHE_ENTRIES
+    #define I2C_OVER_UART_READ_CACHE_ENTRIES        4
+    #endif
+
+    // responses that exceed this length are not cached
+    #ifndef I2C_OVER_UART_READ_CACHE_MAX_LENGTH
+    #define I2C_OVER_UART_READ_CACHE_MAX_LENGTH     8
+    #endif
+
+    // number of addresses that can have a TTL
+    #ifndef I2C_OVER_UART_READ_CACHE_ADDRESSES
+    #define I2C_OVER_UART_READ_CACHE_ADDRESSES      4
+    #endif
+
+    // the master can subscribe to registers of a slave with SerialTwoWireMaster::subscribe().
+    // the slave reads the register every interval using the onReceive and onRequest callbacks
+    // and pushes the value if it has changed or the maximum interval has elapsed.
+    // SerialTwoWireSlave::poll() must be called inside loop()
+    #ifndef I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+    #define I2C_OVER_UART_ENABLE_SUBSCRIPTIONS      0
+    #endif
+
+    // number of subscriptions a slave can serve
+    #ifndef I2C_OVER_UART_SUBSCRIPTIONS
+    #define I2C_OVER_UART_SUBSCRIPTIONS             4
+    #endif
+
+    // maximum length of a subscribed value
+    #ifndef I2C_OVER_UART_SUBSCRIPTION_MAX_LENGTH
+    #define I2C_OVER_UART_SUBSCRIPTION_MAX_LENGTH   8
+    #endif
+
+    // slaves can call deferResponse() inside onRequest and send the response later
+    // with respond(). the master extends its timeout if the slave sends a busy hint
+    #ifndef I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+    #define I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE  0
+    #endif
+
+    // SerialTwoWireMaster::requestFrom() retries after timeouts, NACKs and discarded responses
+    // with a random exponential backoff. see SerialTwoWireMaster::setRetries()
+    #ifndef I2C_OVER_UART_ENABLE_RETRIES
+    #define I2C_OVER_UART_ENABLE_RETRIES            0
+    #endif
+
+    #ifndef I2C_OVER_UART_RETRIES
+    #define I2C_OVER_UART_RETRIES                   3
+    #endif
+
+    // initial delay before retrying in milliseconds
+    #ifndef I2C_OVER_UART_RETRY_BACKOFF
+    #define I2C_OVER_UART_RETRY_BACKOFF             10
+    #endif
+
+    #ifndef I2C_OVER_UART_RETRY_MAX_BACKOFF
+    #define I2C_OVER_UART_RETRY_MAX_BACKOFF         250
+    #endif
+
+    // max. length of the register pointer that is sent again before retrying a request. requests
+    // following a longer transmission to the same address are not retried
+    #ifndef I2C_OVER_UART_RETRY_POINTER_LENGTH
+    #define I2C_OVER_UART_RETRY_POINTER_LENGTH      2
+    #endif
+
+    // token passing between masters sharing the serial line, see SerialTwoWireMaster::setTokenRing()
+    #ifndef I2C_OVER_UART_ENABLE_TOKEN_RING
+    #define I2C_OVER_UART_ENABLE_TOKEN_RING         0
+    #endif
+
+    #ifndef I2C_OVER_UART_TOKEN_RING_MAX_SIZE
+    #define I2C_OVER_UART_TOKEN_RING_MAX_SIZE       4
+    #endif
+
+    // milliseconds a master can keep the token
+    #ifndef I2C_OVER_UART_TOKEN_HOLD_TIME
+    #define I2C_OVER_UART_TOKEN_HOLD_TIME           10
+    #endif
+
+    // the token is regenerated if it has not been seen for this time in milliseconds
+    #ifndef I2C_OVER_UART_TOKEN_TIMEOUT
+    #define I2C_OVER_UART_TOKEN_TIMEOUT             100
+    #endif
+
+    // additional timeout per position in the ring to avoid regenerating multiple tokens
+    #ifndef I2C_OVER_UART_TOKEN_SLOT_TIME
+    #define I2C_OVER_UART_TOKEN_SLOT_TIME           20
+    #endif
+
+    // credit based flow control for point to point links. the receiver reports the number of
+    // bytes it has read and the sender waits if the receive buffer of the other side is full
+    // the window must be the same on both sides and should not exceed the receive buffer
+    #ifndef I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    #define I2C_OVER_UART_ENABLE_FLOW_CONTROL       0
+    #endif
+
+    #ifndef I2C_OVER_UART_FLOW_WINDOW
+    #ifdef SERIAL_RX_BUFFER_SIZE
+    #define I2C_OVER_UART_FLOW_WINDOW               SERIAL_RX_BUFFER_SIZE
+    #else
+    #define I2C_OVER_UART_FLOW_WINDOW               64
+    #endif
+    #endif
+
+    // time in milliseconds to wait for credits before assuming that the update has been lost
+    #ifndef I2C_OVER_UART_FLOW_TIMEOUT
+    #define I2C_OVER_UART_FLOW_TIMEOUT              100
+    #endif
+
+    // credits are reported by poll() if nothing has been received for this time in milliseconds
+    #ifndef I2C_OVER_UART_FLOW_IDLE_TIME
+    #define I2C_OVER_UART_FLOW_IDLE_TIME            10
+    #endif
+
+    // exchange protocol version and features with +I2CN, switch the baud rate of the serial
+    // port and set the I2C clock of the other side with setClock()
+    #ifndef I2C_OVER_UART_ENABLE_NEGOTIATION
+    #define I2C_OVER_UART_ENABLE_NEGOTIATION        0
+    #endif
+
+    // baud rate the serial port is initialized with. the link falls back to the last
+    // baud rate that has been confirmed if switching fails
+    #ifndef I2C_OVER_UART_BAUD_RATE
+    #define I2C_OVER_UART_BAUD_RATE                 115200
+    #endif
+
+    // requests for higher baud rates are rejected
+    #ifndef I2C_OVER_UART_MAX_BAUD_RATE
+    #define I2C_OVER_UART_MAX_BAUD_RATE             2000000
+    #endif
+
+    // time in milliseconds to wait for the answer. the side receiving the request reverts
+    // the baud rate if it has not been confirmed within twice the time
+    #ifndef I2C_OVER_UART_NEGOTIATION_TIMEOUT
+    #define I2C_OVER_UART_NEGOTIATION_TIMEOUT       250
+    #endif
+
+    // SerialTwoWireBridge, forwards transmissions and requests to a TwoWire bus
+    // requires SERIALTWOWIRE_NO_GLOBALS
+    #ifndef I2C_OVER_UART_ENABLE_BRIDGE
+    #define I2C_OVER_UART_ENABLE_BRIDGE             0
+    #endif
+
+    // size of the two static transaction buffers including the address. longer transmissions
+    // are discarded. should match the buffer size of the TwoWire class + 1
+    #ifndef I2C_OVER_UART_BRIDGE_BUFFER_SIZE
+    #if __AVR__
+    #define I2C_OVER_UART_BRIDGE_BUFFER_SIZE        33
+    #else
+    #define I2C_OVER_UART_BRIDGE_BUFFER_SIZE        129
+    #endif
+    #endif
+
+    // transaction programs uploaded by the master and executed by SerialTwoWireBridge
+    #ifndef I2C_OVER_UART_ENABLE_PROGRAMS
+    #define I2C_OVER_UART_ENABLE_PROGRAMS           0
+    #endif
+
+    #ifndef I2C_OVER_UART_PROGRAM_SLOTS
+    #define I2C_OVER_UART_PROGRAM_SLOTS             4
+    #endif
+
+    // max. size of a program in byte
+    #ifndef I2C_OVER_UART_PROGRAM_MAX_LENGTH
+    #define I2C_OVER_UART_PROGRAM_MAX_LENGTH        32
+    #endif
+
+    #if I2C_OVER_UART_ENABLE_PROGRAMS
+    enum class ProgramOpcode : uint8_t {
+        END = 0x00,
+        WRITE = 0x01,                               // address, length, data
+        READ = 0x02,                                // address, length. the data is added to the results
+        DELAY = 0x03,                               // milliseconds, 16 bit big endian
+        JUMP_IF_NACK = 0x04,                        // skip the next n byte of the program if the last WRITE or READ failed
+    };
+    #endif
+
+    // read from multiple devices with a single request, executed by SerialTwoWireBridge
+    #ifndef I2C_OVER_UART_ENABLE_MULTI_READ
+    #define I2C_OVER_UART_ENABLE_MULTI_READ         0
+    #endif
+
+    // SerialTwoWireMaster reads registers periodically without blocking, the results are
+    // received with a callback. SerialTwoWireMaster::poll() must be called inside loop()
+    #ifndef I2C_OVER_UART_ENABLE_SCHEDULER
+    #define I2C_OVER_UART_ENABLE_SCHEDULER          0
+    #endif
+
+    #ifndef I2C_OVER_UART_SCHEDULE_SLOTS
+    #define I2C_OVER_UART_SCHEDULE_SLOTS            8
+    #endif
+
+    // max. number of requests sent without waiting for the response. each address can
+    // only have one request pending
+    #ifndef I2C_OVER_UART_SCHEDULE_PIPELINE
+    #define I2C_OVER_UART_SCHEDULE_PIPELINE         2
+    #endif
+
+    // queue for transmissions of SerialTwoWireMaster, see SerialTwoWireQueue.h. queued frames
+    // are sent by poll() if they fit into the transmit buffer of the serial port
+    #ifndef I2C_OVER_UART_ENABLE_QUEUE
+    #define I2C_OVER_UART_ENABLE_QUEUE              0
+    #endif
+
+    // size of the queue in byte, each frame uses 3 byte + the length of the transmission
+    #ifndef I2C_OVER_UART_QUEUE_SIZE
+    #if __AVR__
+    #define I2C_OVER_UART_QUEUE_SIZE                128
+    #else
+    #define I2C_OVER_UART_QUEUE_SIZE                512
+    #endif
+    #endif
+
+    // number of priority classes, 0 is the highest priority
+    #ifndef I2C_OVER_UART_QUEUE_PRIORITIES
+    #define I2C_OVER_UART_QUEUE_PRIORITIES          3
+    #endif
+
+    #ifndef I2C_OVER_UART_QUEUE_DEFAULT_PRIORITY
+    #define I2C_OVER_UART_QUEUE_DEFAULT_PRIORITY    1
+    #endif
+
+    // number of addresses that can have their own priority or rate limit
+    #ifndef I2C_OVER_UART_QUEUE_ADDRESSES
+    #define I2C_OVER_UART_QUEUE_ADDRESSES           8
+    #endif
+
+    // shadow memory for register ranges of devices, see SerialTwoWireShadow.h
+    #ifndef I2C_OVER_UART_ENABLE_SHADOW
+    #define I2C_OVER_UART_ENABLE_SHADOW             0
+    #endif
+
+    #ifndef I2C_OVER_UART_SHADOW_REGIONS
+    #define I2C_OVER_UART_SHADOW_REGIONS            4
+    #endif
+
+    // max. number of unchanged bytes that are sent to merge two changed runs. a transmission
+    // has an overhead of 11 characters, each byte of data needs 2 characters
+    #ifndef I2C_OVER_UART_SHADOW_MERGE_GAP
+    #define I2C_OVER_UART_SHADOW_MERGE_GAP          5
+    #endif
+
+    // max. length of a transmission including the register. should not exceed the buffer
+    // of the TwoWire class on the other side
+    #ifndef I2C_OVER_UART_SHADOW_MAX_LENGTH
+    #define I2C_OVER_UART_SHADOW_MAX_LENGTH         32
+    #endif
+
+    // compress transmissions of the master with RLE and back references, see SerialTwoWireCompression.h
+    // the sender decides for each frame if compressing reduces its size
+    #ifndef I2C_OVER_UART_ENABLE_COMPRESSION
+    #define I2C_OVER_UART_ENABLE_COMPRESSION        0
+    #endif
+
+    // max. distance of back references that the encoder searches
+    #ifndef I2C_OVER_UART_COMPRESSION_WINDOW
+    #if __AVR__
+    #define I2C_OVER_UART_COMPRESSION_WINDOW        32
+    #else
+    #define I2C_OVER_UART_COMPRESSION_WINDOW        256
+    #endif
+    #endif
+
+    // transmissions shorter than this are not compressed
+    #ifndef I2C_OVER_UART_COMPRESSION_MIN_LENGTH
+    #define I2C_OVER_UART_COMPRESSION_MIN_LENGTH    16
+    #endif
+
+    #if I2C_OVER_UART_ENABLE_COMPRESSION && I2C_OVER_UART_SLAVE_RESPONSE_MASTER_TRANSMIT
+    #error compressed responses are not supported with I2C_OVER_UART_SLAVE_RESPONSE_MASTER_TRANSMIT
+    #endif
+
+    // add 2 check bytes to each frame to correct a single corrupted byte, see SerialTwoWireFec.h
+    // both sides must use the same setting
+    #ifndef I2C_OVER_UART_ENABLE_FEC
+    #define I2C_OVER_UART_ENABLE_FEC                0
+    #endif
+
+    // received frames are stored in a buffer and corrected before processing. longer frames
+    // are discarded. max. 255 byte including the address and the check bytes
+    #ifndef I2C_OVER_UART_FEC_BUFFER_SIZE
+    #if __AVR__
+    #define I2C_OVER_UART_FEC_BUFFER_SIZE           48
+    #else
+    #define I2C_OVER_UART_FEC_BUFFER_SIZE           255
+    #endif
+    #endif
+
+    // add sequence numbers to transmissions. the receiver acknowledges them and suppresses
+    // duplicates, lost frames are sent again, see SerialTwoWireRetransmit.h
+    // both sides must use the same setting
+    #ifndef I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    #define I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY  0
+    #endif
+
+    // size of the buffer for transmissions that have not been acknowledged yet in byte
+    // each frame requires 5 byte extra. longer transmissions are sent without sequence number
+    #ifndef I2C_OVER_UART_RETRANSMIT_BUFFER_SIZE
+    #if __AVR__
+    #define I2C_OVER_UART_RETRANSMIT_BUFFER_SIZE    64
+    #else
+    #define I2C_OVER_UART_RETRANSMIT_BUFFER_SIZE    512
+    #endif
+    #endif
+
+    // frames that have not been acknowledged after this time in milliseconds are sent again
+    #ifndef I2C_OVER_UART_RETRANSMIT_TIMEOUT
+    #define I2C_OVER_UART_RETRANSMIT_TIMEOUT        250
+    #endif
+
+    // max. time to wait for free space in the buffer before the oldest frame is dropped
+    #ifndef I2C_OVER_UART_RETRANSMIT_WAIT
+    #define I2C_OVER_UART_RETRANSMIT_WAIT           2000
+    #endif
+
+    #if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY && I2C_OVER_UART_SLAVE_RESPONSE_MASTER_TRANSMIT
+    #error sequenced transmissions are not supported with I2C_OVER_UART_SLAVE_RESPONSE_MASTER_TRANSMIT
+    #endif
+
+    // restart the parser if a line contains a '+' or the next byte is received after the idle
+    // timeout. a missing newline or a stalled partial line discards the current line only
+    #ifndef I2C_OVER_UART_ENABLE_RESYNC
+    #define I2C_OVER_UART_ENABLE_RESYNC             0
+    #endif
+
+    // max. time between 2 bytes of the same line in milliseconds
+    #ifndef I2C_OVER_UART_IDLE_TIMEOUT
+    #define I2C_OVER_UART_IDLE_TIMEOUT              250
+    #endif
+
+    // frames are written to the serial port with a single call and text from other code is sent
+    // as +REM between frames, see SerialTwoWireRemark.h
+    #ifndef I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+    #define I2C_OVER_UART_ENABLE_OUTPUT_ARBITER     0
+    #endif
+
+    // buffer for a line. longer lines are written in multiple parts
+    #ifndef I2C_OVER_UART_LINE_BUFFER_SIZE
+    #if __AVR__
+    #define I2C_OVER_UART_LINE_BUFFER_SIZE          32
+    #else
+    #define I2C_OVER_UART_LINE_BUFFER_SIZE          576
+    #endif
+    #endif
+
+    // buffer for text waiting to be sent as +REM
+    #ifndef I2C_OVER_UART_REMARK_BUFFER_SIZE
+    #if __AVR__
+    #define I2C_OVER_UART_REMARK_BUFFER_SIZE        64
+    #else
+    #define I2C_OVER_UART_REMARK_BUFFER_SIZE        512
+    #endif
+    #endif
+
+    // max. bytes per second and burst size for +REM, 0 = unlimited
+    #ifndef I2C_OVER_UART_REMARK_RATE
+    #define I2C_OVER_UART_REMARK_RATE               1000
+    #endif
+
+    #ifndef I2C_OVER_UART_REMARK_BURST
+    #if __AVR__
+    #define I2C_OVER_UART_REMARK_BURST              64
+    #else
+    #define I2C_OVER_UART_REMARK_BURST              256
+    #endif
+    #endif
+
+    // handlers for additional commands like "+PING" and a callback for lines that are not
+    // commands, see SerialTwoWireSlave::addCommandHandler() and onUnknownLine()
+    #ifndef I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+    #define I2C_OVER_UART_ENABLE_COMMAND_HANDLERS   0
+    #endif
+
+    // max. number of command handlers
+    #ifndef I2C_OVER_UART_COMMAND_HANDLERS
+    #if __AVR__
+    #define I2C_OVER_UART_COMMAND_HANDLERS          2
+    #else
+    #define I2C_OVER_UART_COMMAND_HANDLERS          8
+    #endif
+    #endif
+
+    // lock-free ring to receive data inside an interrupt with SerialTwoWireSlave::feedFromISR().
+    // feed() without arguments or poll() passes the data to the parser, see SerialTwoWireRing.h
+    #ifndef I2C_OVER_UART_ENABLE_RX_RING
+    #define I2C_OVER_UART_ENABLE_RX_RING            0
+    #endif
+
+    // size of the ring, power of 2. one byte is kept free
+    #ifndef I2C_OVER_UART_RX_RING_SIZE
+    #if __AVR__
+    #define I2C_OVER_UART_RX_RING_SIZE              128
+    #else
+    #define I2C_OVER_UART_RX_RING_SIZE              1024
+    #endif
+    #endif
+
+    // file descriptors, poll() and termios are available
+    #ifndef SERIALTWOWIRE_HAVE_POSIX
+    #if (defined(__unix__) || defined(__APPLE__)) && !defined(ESP8266) && !defined(ESP32)
+    #define SERIALTWOWIRE_HAVE_POSIX                1
+    #else
+    #define SERIALTWOWIRE_HAVE_POSIX                0
+    #endif
+    #endif
+
+    // blocking methods wait with SerialTwoWireSlave::setWaiter() instead of
+    // calling optimistic_yield() in a loop, see SerialTwoWireWaiter.h
+    #ifndef I2C_OVER_UART_ENABLE_WAITER
+    #define I2C_OVER_UART_ENABLE_WAITER             0
+    #endif
+
+    // max. time in milliseconds a waiter blocks before timeouts and retransmissions are checked
+    #ifndef I2C_OVER_UART_WAITER_MAX_WAIT
+    #define I2C_OVER_UART_WAITER_MAX_WAIT           10
+    #endif
+
+    // Stream for file descriptors of serial ports, ptys and sockets and an epoll loop for
+    // multiple instances on Linux, see SerialTwoWireFdStream.h and SerialTwoWireEventLoop.h
+    #ifndef I2C_OVER_UART_ENABLE_POSIX
+    #define I2C_OVER_UART_ENABLE_POSIX              0
+    #endif
+
+    #if I2C_OVER_UART_ENABLE_POSIX && !SERIALTWOWIRE_HAVE_POSIX
+    #error I2C_OVER_UART_ENABLE_POSIX requires a POSIX system
+    #endif
+
+    // size of the read and write buffer of SerialTwoWireFdStream
+    #ifndef I2C_OVER_UART_FD_BUFFER_SIZE
+    #define I2C_OVER_UART_FD_BUFFER_SIZE            1024
+    #endif
+
+    // max. number of file descriptors of SerialTwoWireEventLoop
+    #ifndef I2C_OVER_UART_EVENT_LOOP_ENTRIES
+    #define I2C_OVER_UART_EVENT_LOOP_ENTRIES        64
+    #endif
+
     #if ESP8266
     using stream_read_return_t = int;
     #else
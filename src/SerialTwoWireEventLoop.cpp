@@ -0,0 +1,107 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWireEventLoop.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_POSIX && defined(__linux__)
+
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+
+SerialTwoWireEventLoop::SerialTwoWireEventLoop() :
+    _epollFd(::epoll_create1(EPOLL_CLOEXEC)),
+    _lastPoll(millis()),
+    _count(0)
+{
+    for(auto &entry: _entries) {
+        entry._fd = -1;
+    }
+}
+
+SerialTwoWireEventLoop::~SerialTwoWireEventLoop()
+{
+    if (_epollFd != -1) {
+        ::close(_epollFd);
+    }
+}
+
+bool SerialTwoWireEventLoop::add(int fd, Callback callback)
+{
+    if (_epollFd == -1 || fd == -1) {
+        return false;
+    }
+    for(uint8_t i = 0; i < kMaxEntries; i++) {
+        auto &entry = _entries[i];
+        if (entry._fd == -1) {
+            struct epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.u32 = i;
+            if (::epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+                __LDBG_printf("epoll_ctl fd=%d errno=%d", fd, errno);
+                return false;
+            }
+            entry._fd = fd;
+            entry._callback = callback;
+            _count++;
+            return true;
+        }
+    }
+    __LDBG_printf("no free entry fd=%d", fd);
+    return false;
+}
+
+void SerialTwoWireEventLoop::remove(int fd)
+{
+    for(auto &entry: _entries) {
+        if (entry._fd == fd && fd != -1) {
+            // the file descriptor might have been closed already
+            ::epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            entry._fd = -1;
+            // the callback might be running, it is released when the entry is used again
+            _count--;
+        }
+    }
+}
+
+bool SerialTwoWireEventLoop::run(uint32_t timeout)
+{
+    if (!_count) {
+        return false;
+    }
+    struct epoll_event events[kMaxEntries];
+    int wait = timeout < kPollInterval ? timeout : kPollInterval;
+    int result = ::epoll_wait(_epollFd, events, kMaxEntries, wait);
+    if (result == -1 && errno != EINTR) {
+        __LDBG_printf("epoll_wait errno=%d", errno);
+        return false;
+    }
+    uint32_t now = millis();
+    if ((uint32_t)(now - _lastPoll) >= kPollInterval) {
+        // timers of all objects
+        _lastPoll = now;
+        for(auto &entry: _entries) {
+            if (entry._fd != -1) {
+                entry._callback();
+            }
+        }
+    }
+    else {
+        for(int i = 0; i < result; i++) {
+            auto &entry = _entries[events[i].data.u32];
+            if (entry._fd != -1) {
+                entry._callback();
+            }
+        }
+    }
+    return _count != 0;
+}
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+#include "SerialTwoWireFdStream.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+using namespace SerialTwoWireDef;
+
+#if I2C_OVER_UART_ENABLE_POSIX && defined(__linux__)
+
+#include <functional>
+
+//
+// epoll loop for multiple streams in a single thread
+//
+// run() waits until one of the file descriptors is readable and calls its callback. all
+// callbacks are called every I2C_OVER_UART_WAITER_MAX_WAIT milliseconds to run timers
+// like retransmissions, flow control updates and programs of the bridge
+//
+//  SerialTwoWireFdStream stream;
+//  SerialTwoWireBridge bridge(stream, wire);
+//  stream.open("/dev/ttyUSB0", 115200);
+//  loop.add(stream, bridge);
+//  while (loop.run(1000)) {
+//  }
+//
+class SerialTwoWireEventLoop {
+public:
+    static constexpr uint8_t kMaxEntries = I2C_OVER_UART_EVENT_LOOP_ENTRIES;
+    static constexpr uint16_t kPollInterval = I2C_OVER_UART_WAITER_MAX_WAIT;
+
+    using Callback = std::function<void()>;
+
+public:
+    SerialTwoWireEventLoop();
+    ~SerialTwoWireEventLoop();
+
+    SerialTwoWireEventLoop(const SerialTwoWireEventLoop &) = delete;
+    SerialTwoWireEventLoop &operator=(const SerialTwoWireEventLoop &) = delete;
+
+    // call callback if fd is readable. returns false if there is no free entry or on error
+    bool add(int fd, Callback callback);
+
+    // pass the data of the stream to object.feed() and call object.poll() if the stream is
+    // readable. the stream is removed if the connection has been closed
+    template<typename _Ta>
+    bool add(SerialTwoWireFdStream &stream, _Ta &object);
+
+    void remove(int fd);
+
+    // wait up to timeout milliseconds and call the callbacks. returns false if no file
+    // descriptors are left or on error
+    bool run(uint32_t timeout);
+
+    size_t size() const;
+
+private:
+    struct Entry_t {
+        int _fd;                                // -1 = unused
+        Callback _callback;
+    };
+
+    int _epollFd;
+    uint32_t _lastPoll;
+    uint8_t _count;
+    Entry_t _entries[kMaxEntries];
+};
+
+#include "SerialTwoWireEventLoop.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
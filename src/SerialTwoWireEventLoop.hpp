@@ -0,0 +1,34 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireEventLoop.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+template<typename _Ta>
+bool SerialTwoWireEventLoop::add(SerialTwoWireFdStream &stream, _Ta &object)
+{
+    int fd = stream.getFd();
+    return add(fd, [this, fd, &stream, &object]() {
+        stream.feed(object);
+        object.poll();
+        if (!stream.isConnected()) {
+            remove(fd);
+        }
+    });
+}
+
+inline size_t SerialTwoWireEventLoop::size() const
+{
+    return _count;
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
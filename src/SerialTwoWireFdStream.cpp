@@ -0,0 +1,261 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWireFdStream.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_POSIX
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <errno.h>
+
+SerialTwoWireFdStream::SerialTwoWireFdStream(int fd) :
+    _fd(-1),
+    _connected(false),
+    _tty(false),
+    _rxPosition(0),
+    _rxLength(0),
+    _txLength(0)
+{
+    if (fd != -1) {
+        setFd(fd);
+    }
+}
+
+SerialTwoWireFdStream::~SerialTwoWireFdStream()
+{
+    close();
+}
+
+bool SerialTwoWireFdStream::open(const char *device, uint32_t baudRate)
+{
+    close();
+    int fd = ::open(device, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1) {
+        __LDBG_printf("open device=%s errno=%d", device, errno);
+        return false;
+    }
+    struct termios tio;
+    if (::tcgetattr(fd, &tio) == -1) {
+        __LDBG_printf("tcgetattr device=%s errno=%d", device, errno);
+        ::close(fd);
+        return false;
+    }
+    // raw 8N1 without flow control
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    if (::tcsetattr(fd, TCSANOW, &tio) == -1) {
+        __LDBG_printf("tcsetattr device=%s errno=%d", device, errno);
+        ::close(fd);
+        return false;
+    }
+    setFd(fd);
+    if (!setBaudRate(baudRate)) {
+        close();
+        return false;
+    }
+    ::tcflush(fd, TCIOFLUSH);
+    return true;
+}
+
+bool SerialTwoWireFdStream::setBaudRate(uint32_t baudRate)
+{
+    uint32_t speed;
+    if (!_tty || !_getSpeed(baudRate, speed)) {
+        __LDBG_printf("baud rate %u not supported tty=%u", baudRate, _tty);
+        return false;
+    }
+    flush();
+    struct termios tio;
+    if (::tcgetattr(_fd, &tio) == -1) {
+        return false;
+    }
+    ::cfsetispeed(&tio, (speed_t)speed);
+    ::cfsetospeed(&tio, (speed_t)speed);
+    // wait until the output has been sent with the previous baud rate
+    return ::tcsetattr(_fd, TCSADRAIN, &tio) == 0;
+}
+
+void SerialTwoWireFdStream::setFd(int fd)
+{
+    close();
+    _fd = fd;
+    _connected = true;
+    _tty = ::isatty(fd);
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+void SerialTwoWireFdStream::close()
+{
+    if (_fd != -1) {
+        flush();
+        ::close(_fd);
+        _fd = -1;
+    }
+    _connected = false;
+    _rxPosition = 0;
+    _rxLength = 0;
+    _txLength = 0;
+}
+
+size_t SerialTwoWireFdStream::write(uint8_t data)
+{
+    if (_txLength >= kBufferSize) {
+        flush();
+    }
+    _tx[_txLength++] = data;
+    // frames end with a newline
+    if (data == '\n') {
+        flush();
+    }
+    return 1;
+}
+
+size_t SerialTwoWireFdStream::write(const uint8_t *data, size_t length)
+{
+    struct iovec iov = { const_cast<uint8_t *>(data), length };
+    return writev(&iov, 1);
+}
+
+size_t SerialTwoWireFdStream::writev(const struct iovec *iov, int count)
+{
+    struct iovec vec[kMaxIov];
+    int n = 0;
+    size_t buffered = _txLength;
+    size_t sent = 0;
+    // the buffer is sent first
+    if (_txLength) {
+        vec[n++] = { _tx, _txLength };
+        _txLength = 0;
+    }
+    for(int i = 0; i < count; i++) {
+        if (n == kMaxIov) {
+            sent += _writev(vec, n);
+            n = 0;
+        }
+        vec[n++] = iov[i];
+    }
+    sent += _writev(vec, n);
+    return sent > buffered ? sent - buffered : 0;
+}
+
+void SerialTwoWireFdStream::flush()
+{
+    if (_txLength) {
+        struct iovec iov = { _tx, _txLength };
+        _txLength = 0;
+        _writev(&iov, 1);
+    }
+}
+
+size_t SerialTwoWireFdStream::_fill()
+{
+    if (_rxPosition < _rxLength) {
+        return _rxLength - _rxPosition;
+    }
+    _rxPosition = 0;
+    _rxLength = 0;
+    if (!isConnected()) {
+        return 0;
+    }
+    auto result = ::read(_fd, _rx, kBufferSize);
+    if (result > 0) {
+        _rxLength = (uint16_t)result;
+    }
+    else if ((result == 0 && !_tty) || (result == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        __LDBG_printf("read fd=%d result=%d errno=%d", _fd, (int)result, errno);
+        _connected = false;
+    }
+    return _rxLength;
+}
+
+size_t SerialTwoWireFdStream::_writev(struct iovec *iov, int count)
+{
+    size_t written = 0;
+    while (count && isConnected()) {
+        auto result = ::writev(_fd, iov, count);
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) && _waitForWrite()) {
+                continue;
+            }
+            // error or timeout, the rest is dropped
+            __LDBG_printf("writev fd=%d errno=%d", _fd, errno);
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                _connected = false;
+            }
+            break;
+        }
+        written += result;
+        // skip what has been sent
+        while (count && (size_t)result >= iov->iov_len) {
+            result -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count) {
+            iov->iov_base = reinterpret_cast<uint8_t *>(iov->iov_base) + result;
+            iov->iov_len -= result;
+        }
+    }
+    return written;
+}
+
+bool SerialTwoWireFdStream::_waitForWrite()
+{
+    struct pollfd pfd = { _fd, POLLOUT, 0 };
+    return ::poll(&pfd, 1, (int)getTimeout()) > 0 && (pfd.revents & POLLOUT);
+}
+
+bool SerialTwoWireFdStream::_getSpeed(uint32_t baudRate, uint32_t &speed)
+{
+    static const struct {
+        uint32_t _baudRate;
+        speed_t _speed;
+    } speeds[] = {
+        { 1200, B1200 }, { 2400, B2400 }, { 4800, B4800 }, { 9600, B9600 },
+        { 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 }, { 115200, B115200 },
+#ifdef B230400
+        { 230400, B230400 },
+#endif
+#ifdef B460800
+        { 460800, B460800 },
+#endif
+#ifdef B500000
+        { 500000, B500000 },
+#endif
+#ifdef B921600
+        { 921600, B921600 },
+#endif
+#ifdef B1000000
+        { 1000000, B1000000 },
+#endif
+#ifdef B2000000
+        { 2000000, B2000000 },
+#endif
+    };
+    for(const auto &item: speeds) {
+        if (item._baudRate == baudRate) {
+            speed = item._speed;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+using namespace SerialTwoWireDef;
+
+#if I2C_OVER_UART_ENABLE_POSIX
+
+#include <sys/uio.h>
+
+//
+// Stream for POSIX file descriptors
+//
+// serial ports are opened with open() in raw mode 8N1 without flow control. any other file
+// descriptor like a pty or socket can be passed to the constructor or setFd(). the stream
+// owns the file descriptor and closes it
+//
+// the file descriptor is non-blocking. data is read in chunks of kBufferSize and feed()
+// passes all available data to the parser of a SerialTwoWire object. writes are collected
+// until a newline is written, and a buffer passed to write() is sent together with them
+// using writev(). a write blocks until the data has been sent or the timeout of
+// the stream has passed
+//
+class SerialTwoWireFdStream : public Stream {
+public:
+    static constexpr uint16_t kBufferSize = I2C_OVER_UART_FD_BUFFER_SIZE;
+    // max. number of buffers for a single call of writev()
+    static constexpr uint8_t kMaxIov = 8;
+
+public:
+    SerialTwoWireFdStream(int fd = -1);
+    virtual ~SerialTwoWireFdStream();
+
+    SerialTwoWireFdStream(const SerialTwoWireFdStream &) = delete;
+    SerialTwoWireFdStream &operator=(const SerialTwoWireFdStream &) = delete;
+
+    // open serial port, returns false on error
+    bool open(const char *device, uint32_t baudRate);
+    // change the baud rate of the serial port, can be used as onBaudRate callback
+    bool setBaudRate(uint32_t baudRate);
+    void setFd(int fd);
+    int getFd() const;
+    void close();
+
+    // false if closed, end of file or an error has occurred
+    bool isConnected() const;
+
+    virtual int available() override;
+    virtual int read() override;
+    virtual int peek() override;
+
+    virtual size_t write(uint8_t data) override;
+    virtual size_t write(const uint8_t *data, size_t length) override;
+    using Print::write;
+    // sends the buffer and iov with a single call if possible
+    size_t writev(const struct iovec *iov, int count);
+    virtual void flush() override;
+    virtual int availableForWrite() override;
+
+    // read all available data and call wire.feed() for each byte. returns the number of bytes
+    template<typename _Ta>
+    size_t feed(_Ta &wire);
+
+private:
+    // read the next chunk if the buffer is empty, returns the number of bytes in the buffer
+    size_t _fill();
+    size_t _writev(struct iovec *iov, int count);
+    bool _waitForWrite();
+    static bool _getSpeed(uint32_t baudRate, uint32_t &speed);
+
+    int _fd;
+    bool _connected;
+    bool _tty;                                  // read() returns 0 if no data is available
+    uint16_t _rxPosition;
+    uint16_t _rxLength;
+    uint16_t _txLength;
+    uint8_t _rx[kBufferSize];
+    uint8_t _tx[kBufferSize];
+};
+
+#include "SerialTwoWireFdStream.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,67 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireFdStream.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+inline int SerialTwoWireFdStream::getFd() const
+{
+    return _fd;
+}
+
+inline bool SerialTwoWireFdStream::isConnected() const
+{
+    return _fd != -1 && _connected;
+}
+
+inline int SerialTwoWireFdStream::available()
+{
+    return (int)_fill();
+}
+
+inline int SerialTwoWireFdStream::read()
+{
+    if (!_fill()) {
+        return -1;
+    }
+    return _rx[_rxPosition++];
+}
+
+inline int SerialTwoWireFdStream::peek()
+{
+    if (!_fill()) {
+        return -1;
+    }
+    return _rx[_rxPosition];
+}
+
+inline int SerialTwoWireFdStream::availableForWrite()
+{
+    return kBufferSize - _txLength;
+}
+
+template<typename _Ta>
+size_t SerialTwoWireFdStream::feed(_Ta &wire)
+{
+    size_t count = 0;
+    size_t length;
+    while ((length = _fill()) != 0) {
+        // the parser might call feed() again while waiting for a response
+        do {
+            wire.feed(_rx[_rxPosition++]);
+            count++;
+        } while (_rxPosition < _rxLength);
+    }
+    return count;
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
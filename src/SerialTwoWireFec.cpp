@@ -0,0 +1,49 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWireFec.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_FEC
+
+SerialTwoWireFec::ResultType SerialTwoWireFec::correct(uint8_t *data, uint8_t length)
+{
+    if (length <= kLength) {
+        return ResultType::UNCORRECTABLE;
+    }
+    length -= kLength;
+    SerialTwoWireFec fec;
+    for(uint8_t i = 0; i < length; i++) {
+        fec.update(data[i]);
+    }
+    // the error value and the error value multiplied by its position
+    uint8_t error = fec._parity ^ data[length];
+    uint8_t weightedError = fec._weightedSum ^ data[length + 1];
+    if (error == 0 && weightedError == 0) {
+        return ResultType::NONE;
+    }
+    if (error == 0 || weightedError == 0) {
+        // one of the check bytes is corrupted
+        __LDBG_printf("check byte error=%02x weighted=%02x", error, weightedError);
+        return ResultType::CORRECTED;
+    }
+    uint8_t value = error;
+    for(uint8_t i = 0; i < length; i++) {
+        if (value == weightedError) {
+            __LDBG_printf("pos=%u error=%02x", length - 1 - i, error);
+            data[length - 1 - i] ^= error;
+            return ResultType::CORRECTED;
+        }
+        value = _multiply(value);
+    }
+    __LDBG_printf("error=%02x weighted=%02x len=%u", error, weightedError, length);
+    return ResultType::UNCORRECTABLE;
+}
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+using namespace SerialTwoWireDef;
+
+#if I2C_OVER_UART_ENABLE_FEC
+
+//
+// Forward error correction
+//
+// two check bytes are appended to the binary data of each frame. the first one is the xor of
+// all bytes, the second one the sum of all bytes weighted with their position in GF(2^8)
+//
+// p = d[0] ^ d[1] ^ ... ^ d[n - 1]
+// q = d[0] * a^(n - 1) ^ d[1] * a^(n - 2) ^ ... ^ d[n - 1]
+//
+// a single corrupted byte is located by comparing the difference of both check bytes and
+// corrected in place. the check bytes are calculated while the data is encoded and decoded,
+// no tables are used
+//
+class SerialTwoWireFec {
+public:
+    static constexpr uint8_t kLength = 2;
+    // max. length including the check bytes, the position must be unique
+    static constexpr uint8_t kMaxLength = 255;
+
+    enum class ResultType : uint8_t {
+        NONE,                                       // no error
+        CORRECTED,                                  // a single byte has been corrected
+        UNCORRECTABLE,
+    };
+
+    struct Stats {
+        uint32_t _frames;                           // frames received
+        uint32_t _corrected;                        // frames with a corrected byte
+        uint32_t _uncorrectable;                    // frames discarded
+
+        Stats() : _frames(0), _corrected(0), _uncorrectable(0) {}
+    };
+
+public:
+    SerialTwoWireFec();
+
+    void begin();
+    void update(uint8_t data);
+    // number of bytes added since begin()
+    uint8_t length() const;
+    uint8_t getParity() const;
+    uint8_t getWeightedSum() const;
+
+    // length includes the check bytes
+    static ResultType correct(uint8_t *data, uint8_t length);
+
+private:
+    // multiply by a = 2 with the polynomial 0x11d
+    static uint8_t _multiply(uint8_t value);
+
+    uint8_t _parity;
+    uint8_t _weightedSum;
+    uint8_t _length;
+};
+
+#include "SerialTwoWireFec.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
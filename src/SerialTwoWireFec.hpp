@@ -0,0 +1,54 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireFec.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+inline SerialTwoWireFec::SerialTwoWireFec() : _parity(0), _weightedSum(0), _length(0)
+{
+}
+
+inline void SerialTwoWireFec::begin()
+{
+    _parity = 0;
+    _weightedSum = 0;
+    _length = 0;
+}
+
+inline void SerialTwoWireFec::update(uint8_t data)
+{
+    _parity ^= data;
+    _weightedSum = _multiply(_weightedSum) ^ data;
+    _length++;
+}
+
+inline uint8_t SerialTwoWireFec::length() const
+{
+    return _length;
+}
+
+inline uint8_t SerialTwoWireFec::getParity() const
+{
+    return _parity;
+}
+
+inline uint8_t SerialTwoWireFec::getWeightedSum() const
+{
+    return _weightedSum;
+}
+
+inline uint8_t SerialTwoWireFec::_multiply(uint8_t value)
+{
+    return (value & 0x80) ? ((value << 1) ^ 0x1d) : (value << 1);
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
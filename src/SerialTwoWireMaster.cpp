@@ -16,51 +16,104 @@
 
 uint8_t SerialTwoWireMaster::requestFrom(uint8_t address, uint8_t count, uint8_t stop)
 {
-    __LDBG_printf("addr=%02x count=%u stop=%u len=%u outs=%u", address, count, stop, _request().length(), flags()._outState);
+    __LDBG_printf("addr=%02x count=%u stop=%u len=%u outs=%u", address, count, stop, _request().length(), flags()._requestState);
 
     if (count == 0 || !isValidAddress(address)) {
         return 0;
     }
 
-    flags()._setOutState(OutStateType::FILL);
-    // discard any data from previous requests
-    _request().clear();
-    _request().write(address);
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+    // a register pointer written to another address was not followed by a request
+    if (_sendPendingRegister(address)) {
+        return 0;
+    }
+    auto cached = _readCache.get(address, count);
+    if (cached) {
+        __LDBG_printf("cached addr=%02x count=%u", address, count);
+        // a deferred byte that is not the register pointer of the entry is still sent
+        if (_sendPendingRegister()) {
+            return 0;
+        }
+        _request().clear();
+        _request().write(cached, count);
+        flags()._setRequestState(OutStateType::NONE);
+        return count;
+    }
+#endif
 
-    // send request
-#if I2C_OVER_UART_ADD_CRC16
-    auto crc = _crc16_update(_crc16_update(~0, address), count);
+#if I2C_OVER_UART_ENABLE_QUEUE
+    // queued transmissions to the address must arrive before the request
+    _flushQueue(address);
 #endif
-    // write as fast as possible
-    _serial->flush();
-    size_t written = sendCommandStr(*_serial, CommandStringType::MASTER_REQUEST);
-    written += _printHex(address);
-    written += _printHex(count);
-#if I2C_OVER_UART_ADD_CRC16
-    written += _printHexCrc(crc);
-    __LDBG_assertf(written == kRequestCommandLength + 10, "written=%u expected=%u", written,kRequestCommandLength + 10);
-    if (written != kRequestCommandLength + 10) {
+
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    if (!_acquireToken()) {
         return 0;
     }
-#else
-    written += _println();
-    __LDBG_assertf(written == kRequestCommandLength + 5, "written=%u expected=%u", written, kRequestCommandLength + 5);
-    if (written != kCommandMaxLength + 5) {
-        return 0;
+#endif
+
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+    uint8_t reg;
+    if (_readCache.getPendingRegister(address, reg)) {
+        // send register pointer that has been deferred by endTransmission()
+        beginTransmission(address);
+        _out.write(reg);
+        _endTransmission(CommandStringType::MASTER_TRANSMIT, true);
     }
 #endif
-    _serial->flush();
 
+#if I2C_OVER_UART_ENABLE_RETRIES
+    _retryStats._requests++;
+    // the register pointer is sent again before each retry, the device might have received it
+    // and the request incremented it already
+    bool hasPointer = _retryPointer._address == address;
+    uint8_t retries = (hasPointer && _retryPointer._length > kRetryPointerLength) ? 0 : _retries;
+    _retryPointer._address = kNotInitializedAddress;
+    uint8_t result;
+    for(uint8_t retry = 0; ; retry++) {
+        result = _sendRequest(address, count);
+        if (result || retry >= retries) {
+            break;
+        }
+        _retryStats._retries++;
+        _backoff(retry);
+        if (hasPointer) {
+            beginTransmission(address);
+            _out.write(_retryPointer._data, _retryPointer._length);
+            _endTransmission(CommandStringType::MASTER_TRANSMIT, true);
+        }
+    }
+    if (!result) {
+        _retryStats._failed++;
+    }
+#else
+    auto result = _sendRequest(address, count);
+#endif
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+    _readCache.update(address, result == count ? _request().begin() : nullptr, result);
+#endif
+    return result;
+}
+
+uint8_t SerialTwoWireMaster::_sendRequest(uint8_t address, uint8_t count)
+{
+    flags()._setRequestState(OutStateType::FILL);
+    // discard any data from previous requests
+    _request().clear();
+    _request().write(address);
+
+    if (!_writeRequest(address, count)) {
+        return 0;
+    }
 
     // wait for response
 #if DEBUG_SERIALTWOWIRE
     auto start = micros();
     auto result = _waitForResponse(address, count);
     auto dur = micros() - start;
-    __DBG_printf("response=%d time=%uus can_yield=%u outs=%u", result, dur, can_yield(), flags()._outState);
-    return result;
+    __DBG_printf("response=%d time=%uus can_yield=%u outs=%u", result, dur, can_yield(), flags()._requestState);
 #else
-    return _waitForResponse(address, count);
+    auto result = _waitForResponse(address, count);
     // if (result) {
     //     Serial.printf("out(%u):", _out.available());
     //     for(char ch: _out) {
@@ -74,20 +127,725 @@ uint8_t SerialTwoWireMaster::requestFrom(uint8_t address, uint8_t count, uint8_t
     //     Serial.println();
     // }
 #endif
+    return result;
+}
+
+bool SerialTwoWireMaster::_writeRequest(uint8_t address, uint8_t count)
+{
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    _waitForCredits(_getFrameLength(2));
+#endif
+    // write as fast as possible
+    _serial->flush();
+    size_t written = _printCommand(CommandStringType::MASTER_REQUEST);
+#if I2C_OVER_UART_ADD_CRC16
+    checksum_t crc = Checksum::kInit;
+    written += _printHexUpdateCrc(address, crc);
+    written += _printHexUpdateCrc(count, crc);
+    written += _printHexCrc(crc);
+#else
+    written += _printHex(address);
+    written += _printHex(count);
+    written += _println();
+#endif
+    __LDBG_assertf(written == _getFrameLength(2), "written=%u expected=%u", written, _getFrameLength(2));
+    if (written != _getFrameLength(2)) {
+        return false;
+    }
+    _serial->flush();
+    return true;
+}
+
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+
+uint8_t SerialTwoWireMaster::_sendPendingRegister(uint8_t except)
+{
+    uint8_t frame[2];
+    if (!_readCache.getPendingAddress(frame[0]) || frame[0] == except) {
+        return static_cast<uint8_t>(EndTransmissionCode::SUCCESS);
+    }
+#if I2C_OVER_UART_ENABLE_QUEUE
+    _flushQueue(frame[0]);
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    // the register pointer remains pending
+    if (!_acquireToken()) {
+        return static_cast<uint8_t>(EndTransmissionCode::TIMEOUT);
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    if (!_waitForCredits(_getFrameLength(sizeof(frame)))) {
+        // the credits have been reset, the next call sends it
+        return static_cast<uint8_t>(EndTransmissionCode::TIMEOUT);
+    }
+#endif
+    _readCache.getPendingRegister(frame[0], frame[1]);
+    __LDBG_printf("addr=%02x reg=%02x", frame[0], frame[1]);
+    _serial->flush();
+    auto complete = _printFrame(CommandStringType::MASTER_TRANSMIT, frame, sizeof(frame));
+    _serial->flush();
+    if (!complete) {
+        __LDBG_printf("write failed");
+        return static_cast<uint8_t>(EndTransmissionCode::OTHER);
+    }
+    return static_cast<uint8_t>(EndTransmissionCode::SUCCESS);
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_RETRIES
+
+void SerialTwoWireMaster::_backoff(uint8_t retry)
+{
+    uint32_t delay = (uint32_t)_retryBackoff << (retry < 16 ? retry : 16);
+    if (delay > _retryMaxBackoff) {
+        delay = _retryMaxBackoff;
+    }
+    // random delay between 50 and 100%
+    delay = (delay / 2) + random(delay / 2 + 1);
+    __LDBG_printf("retry=%u delay=%u", retry, delay);
+    auto start = millis();
+    while((uint32_t)(millis() - start) < delay) {
+        _wait(start, delay);
+    }
+}
+
+#endif
+
+uint8_t SerialTwoWireMaster::endTransmission(uint8_t stop)
+{
+#if I2C_OVER_UART_ENABLE_RETRIES
+    if (flags()._getOutState() == OutStateType::LOCKED && _out.length() > 1) {
+        // store the register pointer for retrying the next request
+        auto length = _out.length() - 1;
+        _retryPointer._address = _out[0];
+        _retryPointer._length = length > kRetryPointerLength ? kRetryPointerLength + 1 : length;
+        memcpy(_retryPointer._data, _out.begin() + 1, _retryPointer._length > kRetryPointerLength ? 0 : length);
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+    if (flags()._getOutState() == OutStateType::LOCKED) {
+        // the previous register pointer was not followed by a request
+        auto code = _sendPendingRegister();
+        if (code) {
+            _out.clear();
+            flags()._setOutState(OutStateType::NONE);
+            return code;
+        }
+        if (_out.length() > 1 && _readCache.transmit(_out[0], &_out[1], _out.length() - 1)) {
+            __LDBG_printf("deferred addr=%02x reg=%02x", _out[0], _out[1]);
+            _out.clear();
+            flags()._setOutState(OutStateType::NONE);
+            return static_cast<uint8_t>(EndTransmissionCode::SUCCESS);
+        }
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    if (flags()._getOutState() == OutStateType::LOCKED && _peer._maxLength && _out.length() > _peer._maxLength) {
+        __LDBG_printf("len=%u max=%u", _out.length(), _peer._maxLength);
+        _out.clear();
+        flags()._setOutState(OutStateType::NONE);
+        return static_cast<uint8_t>(EndTransmissionCode::DATA_TOO_LONG);
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_QUEUE
+    if (flags()._getOutState() == OutStateType::LOCKED && isValidAddress(_out.peek()) && _out.peek() != data()._address && _queueTransmission()) {
+        _out.clear();
+        flags()._setOutState(OutStateType::NONE);
+        // send it right away if the transmit buffer has enough space
+        _pollQueue();
+        return static_cast<uint8_t>(EndTransmissionCode::SUCCESS);
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    if (flags()._getOutState() == OutStateType::LOCKED && !_acquireToken()) {
+        _out.clear();
+        flags()._setOutState(OutStateType::NONE);
+        return static_cast<uint8_t>(EndTransmissionCode::TIMEOUT);
+    }
+#endif
+    return SerialTwoWireSlave::endTransmission(stop);
+}
+
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+
+uint8_t SerialTwoWireMaster::uploadProgram(uint8_t slot, const uint8_t *program, uint8_t length)
+{
+    if (slot >= kProgramSlots) {
+        return static_cast<uint8_t>(EndTransmissionCode::INVALID_ADDRESS);
+    }
+    if (length > kProgramMaxLength) {
+        return static_cast<uint8_t>(EndTransmissionCode::DATA_TOO_LONG);
+    }
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    if (!_acquireToken()) {
+        return static_cast<uint8_t>(EndTransmissionCode::TIMEOUT);
+    }
+#endif
+    beginTransmission(slot);
+    _out.write(program, length);
+    return _endTransmission(CommandStringType::PROGRAM, true);
+}
+
+uint8_t SerialTwoWireMaster::runProgram(uint8_t slot, uint8_t length)
+{
+    _programStatus = static_cast<uint8_t>(EndTransmissionCode::INVALID_ADDRESS);
+    if (slot >= kProgramSlots) {
+        return 0;
+    }
+#if I2C_OVER_UART_ENABLE_QUEUE
+    // the program might depend on queued transmissions
+    flushQueue();
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    _programStatus = static_cast<uint8_t>(EndTransmissionCode::TIMEOUT);
+    if (!_acquireToken()) {
+        return 0;
+    }
+#endif
+    // the results are received like a response to requestFrom()
+    uint8_t address = kProgramAddress + slot;
+    flags()._setRequestState(OutStateType::FILL);
+    _request().clear();
+    _request().write(address);
+    beginTransmission(slot);
+    _endTransmission(CommandStringType::RUN_PROGRAM, true);
+    // errors are answered with the status only
+    if (_waitForResponse(address, 1) == 0) {
+        _programStatus = static_cast<uint8_t>(EndTransmissionCode::TIMEOUT);
+        return 0;
+    }
+    _programStatus = _request().read();
+    if (_request().available() < length) {
+        __LDBG_printf("slot=%u status=%u len=%u expected=%u", slot, _programStatus, _request().available(), length);
+        if (!_programStatus) {
+            _programStatus = static_cast<uint8_t>(EndTransmissionCode::OTHER);
+        }
+        _request().clear();
+        return 0;
+    }
+    return length;
+}
+
+uint8_t SerialTwoWireMaster::repeatProgram(uint8_t slot, uint16_t interval)
+{
+    if (slot >= kProgramSlots) {
+        return static_cast<uint8_t>(EndTransmissionCode::INVALID_ADDRESS);
+    }
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    if (!_acquireToken()) {
+        return static_cast<uint8_t>(EndTransmissionCode::TIMEOUT);
+    }
+#endif
+    beginTransmission(slot);
+    _out.write(interval >> 8);
+    _out.write((uint8_t)interval);
+    return _endTransmission(CommandStringType::RUN_PROGRAM, true);
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+
+uint8_t SerialTwoWireMaster::readMultiple(MultiRead_t *items, uint8_t count)
+{
+    // number of items, address, register and length for each item
+    uint16_t requestLength = 1 + count * 3;
+    // status and data for each item
+    uint16_t responseLength = 0;
+    for(uint8_t i = 0; i < count; i++) {
+        items[i]._status = static_cast<uint8_t>(EndTransmissionCode::TIMEOUT);
+        responseLength += 1 + items[i]._length;
+    }
+    if (count == 0 || requestLength > kTransmissionMaxLength || responseLength >= kTransmissionMaxLength) {
+        return 0;
+    }
+#if I2C_OVER_UART_ENABLE_QUEUE
+    flushQueue();
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    if (!_acquireToken()) {
+        return 0;
+    }
+#endif
+    // the results are received like a response to requestFrom()
+    flags()._setRequestState(OutStateType::FILL);
+    _request().clear();
+    _request().write(kMultiReadAddress);
+    beginTransmission(count);
+    for(uint8_t i = 0; i < count; i++) {
+        _out.write(items[i]._address);
+        _out.write(items[i]._register);
+        _out.write(items[i]._length);
+    }
+    _endTransmission(CommandStringType::MULTI_READ, true);
+    if (_waitForResponse(kMultiReadAddress, responseLength) == 0) {
+        return 0;
+    }
+    uint8_t success = 0;
+    for(uint8_t i = 0; i < count; i++) {
+        auto &item = items[i];
+        item._status = _request().read();
+        _request().read(item._data, item._length);
+        if (item._status == static_cast<uint8_t>(EndTransmissionCode::SUCCESS)) {
+            success++;
+        }
+    }
+    return success;
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+
+uint8_t SerialTwoWireMaster::negotiate(uint32_t baudRate, uint32_t clock)
+{
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    if (!_acquireToken()) {
+        return static_cast<uint8_t>(EndTransmissionCode::TIMEOUT);
+    }
+#endif
+    if (!_onBaudRate || baudRate == _baudRate) {
+        baudRate = 0;
+    }
+    auto result = _negotiate(NegotiationType::REQUEST, clock, baudRate);
+    if (result != static_cast<uint8_t>(EndTransmissionCode::SUCCESS)) {
+        return result;
+    }
+    if ((_peer._features ^ kFeatures) & kFeatureFramingMask) {
+        __LDBG_printf("features=%02x peer=%02x", kFeatures, _peer._features);
+        return static_cast<uint8_t>(EndTransmissionCode::OTHER);
+    }
+    if (!baudRate || _peer._baudRate != baudRate) {
+        // rejected or not requested
+        return static_cast<uint8_t>(EndTransmissionCode::SUCCESS);
+    }
+    if (!_invokeOnBaudRate(baudRate)) {
+        // the other side reverts after the timeout
+        return static_cast<uint8_t>(EndTransmissionCode::OTHER);
+    }
+    result = _negotiate(NegotiationType::CONFIRM, 0, baudRate);
+    if (result != static_cast<uint8_t>(EndTransmissionCode::SUCCESS)) {
+        __LDBG_printf("baud rate %u not confirmed, revert to %u", baudRate, _baudRate);
+        _invokeOnBaudRate(_baudRate);
+        // terminate the line the other side might have received with a different baud rate
+        _println();
+        return result;
+    }
+    _baudRate = baudRate;
+    // ends the fallback timer of the other side, any other frame does as well
+    _sendNegotiation(NegotiationType::COMMIT, 0, baudRate);
+    return static_cast<uint8_t>(EndTransmissionCode::SUCCESS);
+}
+
+uint8_t SerialTwoWireMaster::_negotiate(NegotiationType type, uint32_t clock, uint32_t baudRate)
+{
+    // REQUEST is answered with RESPONSE and CONFIRM with CONFIRMED
+    auto expected = static_cast<NegotiationType>(static_cast<uint8_t>(type) + 1);
+    _negotiationReceived = NegotiationType::NONE;
+    _sendNegotiation(type, clock, baudRate);
+    auto start = millis();
+    while (_negotiationReceived != expected) {
+        if ((uint32_t)(millis() - start) > I2C_OVER_UART_NEGOTIATION_TIMEOUT) {
+            __LDBG_printf("timeout type=%u", type);
+            return static_cast<uint8_t>(EndTransmissionCode::TIMEOUT);
+        }
+        _wait(start, I2C_OVER_UART_NEGOTIATION_TIMEOUT);
+    }
+    return static_cast<uint8_t>(EndTransmissionCode::SUCCESS);
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+
+bool SerialTwoWireMaster::setTokenRing(const uint8_t *masters, uint8_t count, uint16_t holdTime, uint16_t timeout)
+{
+    _tokenRingSize = 0;
+    _hasToken = false;
+    if (count == 0) {
+        return true;
+    }
+    if (count > kTokenRingMaxSize) {
+        return false;
+    }
+    // insert sorted
+    for(uint8_t i = 0; i < count; i++) {
+        uint8_t j = i;
+        for(; j > 0 && _tokenRing[j - 1] > masters[i]; j--) {
+            _tokenRing[j] = _tokenRing[j - 1];
+        }
+        _tokenRing[j] = masters[i];
+    }
+    _tokenPosition = count;
+    for(uint8_t i = 0; i < count; i++) {
+        if (_tokenRing[i] == data()._getAddress()) {
+            _tokenPosition = i;
+        }
+    }
+    __LDBG_assertf(_tokenPosition < count, "own address=%02x not in the token ring", data()._getAddress());
+    if (_tokenPosition >= count) {
+        return false;
+    }
+    _tokenRingSize = count;
+    _tokenHoldTime = holdTime;
+    _tokenTimeout = timeout;
+    _tokenLastSeen = millis();
+    return true;
 }
 
+bool SerialTwoWireMaster::_acquireToken()
+{
+    if (!_tokenRingSize) {
+        return true;
+    }
+    auto start = millis();
+    for(;;) {
+        if (_hasToken) {
+            if ((uint32_t)(millis() - _tokenReceived) < _tokenHoldTime) {
+                return true;
+            }
+            // hold time exceeded, wait for the next round
+            _passToken();
+        }
+        if ((uint32_t)(millis() - start) > _timeout) {
+            __LDBG_printf("token timeout");
+            return false;
+        }
+        _wait(start, _timeout);
+        _checkTokenTimeout();
+    }
+}
+
+void SerialTwoWireMaster::_passToken()
+{
+    // _out might be locked by endTransmission(), the frame is sent directly
+    uint8_t frame[1] = { _tokenRing[(_tokenPosition + 1) % _tokenRingSize] };
+    __LDBG_printf("pass token to=%02x", frame[0]);
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    _waitForCredits(_getFrameLength(sizeof(frame)));
+#endif
+    _serial->flush();
+    auto complete = _printFrame(CommandStringType::TOKEN, frame, sizeof(frame));
+    _serial->flush();
+    if (!complete) {
+        // keep the token and try again
+        __LDBG_printf("pass token failed");
+        return;
+    }
+    _hasToken = false;
+    _tokenStats._passed++;
+    _tokenLastSeen = millis();
+}
+
+void SerialTwoWireMaster::_checkTokenTimeout()
+{
+    // masters with a lower address regenerate the token first
+    if (!_hasToken && (uint32_t)(millis() - _tokenLastSeen) > _tokenTimeout + (uint32_t)_tokenPosition * I2C_OVER_UART_TOKEN_SLOT_TIME) {
+        __LDBG_printf("regenerate token");
+        _tokenStats._regenerated++;
+        _hasToken = true;
+        _tokenReceived = millis();
+        _tokenLastSeen = _tokenReceived;
+    }
+}
+
+void SerialTwoWireMaster::_processToken()
+{
+    if (!_tokenRingSize || _in.length() != 1) {
+        return;
+    }
+    _tokenLastSeen = millis();
+    if (_in[0] == data()._getAddress()) {
+        _tokenStats._received++;
+        _hasToken = true;
+        _tokenReceived = _tokenLastSeen;
+    }
+    else if (_hasToken) {
+        // another master is passing a token
+        __LDBG_printf("drop duplicate token");
+        _tokenStats._dropped++;
+        _hasToken = false;
+    }
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_TOKEN_RING || I2C_OVER_UART_ENABLE_SCHEDULER || I2C_OVER_UART_ENABLE_QUEUE || I2C_OVER_UART_ENABLE_READ_CACHE
+
+void SerialTwoWireMaster::poll()
+{
+    SerialTwoWireSlave::poll();
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+    _sendPendingRegister();
+#endif
+#if I2C_OVER_UART_ENABLE_QUEUE
+    _pollQueue();
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    if (_tokenRingSize) {
+        if (_hasToken) {
+            if ((uint32_t)(millis() - _tokenReceived) >= _tokenHoldTime) {
+                _passToken();
+            }
+        }
+        else {
+            _checkTokenTimeout();
+        }
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_SCHEDULER
+    _pollSchedule();
+#endif
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_QUEUE
+
+bool SerialTwoWireMaster::_queueTransmission()
+{
+    auto length = _out.length();
+    if (!_queue.push(_out.begin(), length)) {
+        if (SerialTwoWireQueue::kHeaderSize + length > SerialTwoWireQueue::kSize) {
+            // send directly after all queued transmissions
+            flushQueue();
+            return false;
+        }
+        // the queue is full, wait until enough frames have been sent respecting the rate limits
+        while (!_queue.fits(length) && _sendQueued(SerialTwoWireQueue::kUnused, true, true)) {
+        }
+        _queue.push(_out.begin(), length);
+    }
+    return true;
+}
+
+bool SerialTwoWireMaster::_sendQueued(uint8_t address, bool wait, bool limits)
+{
+    uint8_t length;
+    auto frame = _queue.next(length, address, limits);
+    if (wait) {
+        // wait for the rate limit. frames of a single address are returned without limit
+        while (!frame && address == SerialTwoWireQueue::kUnused && !_queue.empty()) {
+            _wait(millis(), 1);
+            frame = _queue.next(length, address, limits);
+        }
+        if (!frame) {
+            return false;
+        }
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+        if (!_acquireToken()) {
+            // drop the frame like endTransmission() without token
+            _queue.pop(frame);
+            return true;
+        }
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+        _waitForCredits(_getFrameLength(length));
+#endif
+        _serial->flush();
+    }
+    else {
+        // send only if it does not block
+        if (!frame || _serial->availableForWrite() < (int)_getFrameLength(length)) {
+            return false;
+        }
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+        if (_tokenRingSize && !_hasToken) {
+            return false;
+        }
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+        if (_flowCredits < (length > kFlowWindow ? kFlowWindow : length) || flags()._processing) {
+            return false;
+        }
+        _waitForCredits(_getFrameLength(length));
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+        if (!_retransmit.fits(length) && SerialTwoWireRetransmit::isValidLength(length)) {
+            return false;
+        }
+#endif
+    }
+    __LDBG_printf("addr=%02x len=%u", frame[0], length);
+    _printFrame(CommandStringType::MASTER_TRANSMIT, frame, length);
+    _queue.pop(frame);
+    return true;
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_SCHEDULER
+
+uint8_t SerialTwoWireMaster::addSchedule(uint8_t address, uint8_t reg, uint8_t length, uint16_t interval)
+{
+    if (!isValidAddress(address) || length == 0 || interval == 0) {
+        return kInvalidSchedule;
+    }
+    for(uint8_t id = 0; id < kScheduleSlots; id++) {
+        auto &item = _schedule[id];
+        if (item._interval == 0) {
+            item._address = address;
+            item._register = reg;
+            item._length = length;
+            item._interval = interval;
+            item._pending = false;
+            // spread reads with the same interval evenly instead of sending them in a burst
+            item._due = millis() + (uint32_t)interval * id / kScheduleSlots;
+            return id;
+        }
+    }
+    return kInvalidSchedule;
+}
+
+void SerialTwoWireMaster::_pollSchedule()
+{
+    auto now = millis();
+    uint8_t pending = 0;
+    for(uint8_t id = 0; id < kScheduleSlots; id++) {
+        auto &item = _schedule[id];
+        if (item._pending) {
+            if ((uint32_t)(now - item._sent) > _timeout) {
+                __LDBG_printf("id=%u addr=%02x timeout", id, item._address);
+                item._pending = false;
+                _scheduleStats._timeouts++;
+                // _in belongs to the frame being received
+                _invokeOnScheduledRead(id, static_cast<uint8_t>(EndTransmissionCode::TIMEOUT), 0);
+            }
+            else {
+                pending++;
+            }
+        }
+    }
+    // do not interfere with a transmission in progress
+    if (flags()._getOutState() != OutStateType::NONE) {
+        return;
+    }
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    if (_tokenRingSize && !_hasToken) {
+        return;
+    }
+#endif
+    // the most overdue read is sent first
+    while (pending < kSchedulePipeline) {
+        uint8_t next = kInvalidSchedule;
+        for(uint8_t id = 0; id < kScheduleSlots; id++) {
+            auto &item = _schedule[id];
+            if (item._interval && !item._pending && (int32_t)(now - item._due) >= 0 && _findPendingSchedule(item._address) == kInvalidSchedule) {
+                if (next == kInvalidSchedule || (int32_t)(_schedule[next]._due - item._due) > 0) {
+                    next = id;
+                }
+            }
+        }
+        if (next == kInvalidSchedule) {
+            break;
+        }
+        _sendScheduledRead(next, now);
+        pending++;
+    }
+}
+
+void SerialTwoWireMaster::_sendScheduledRead(uint8_t id, uint32_t now)
+{
+    auto &item = _schedule[id];
+    uint32_t jitter = now - item._due;
+    if (jitter >= item._interval) {
+        // skip the periods that have been missed and keep the phase to avoid drifting
+        auto missed = jitter / item._interval;
+        _scheduleStats._missed += missed;
+        item._due += missed * item._interval;
+        jitter -= missed * item._interval;
+    }
+    item._due += item._interval;
+#if I2C_OVER_UART_ENABLE_QUEUE
+    _flushQueue(item._address);
+#endif
+    item._pending = true;
+    item._sent = now;
+    _scheduleStats._requests++;
+    _scheduleStats._totalJitter += jitter;
+    if (jitter > _scheduleStats._maxJitter) {
+        _scheduleStats._maxJitter = jitter;
+    }
+    // the register pointer and the request are sent without waiting for the response
+    beginTransmission(item._address);
+    _out.write(item._register);
+    _endTransmission(CommandStringType::MASTER_TRANSMIT, true);
+    if (!_writeRequest(item._address, item._length)) {
+        __LDBG_printf("id=%u addr=%02x write failed", id, item._address);
+        item._pending = false;
+        _invokeOnScheduledRead(id, static_cast<uint8_t>(EndTransmissionCode::OTHER), 0);
+    }
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+
+uint8_t SerialTwoWireMaster::subscribe(uint8_t address, uint8_t reg, uint8_t length, uint16_t interval, uint16_t maxInterval)
+{
+    if (!isValidAddress(address)) {
+        return static_cast<uint8_t>(EndTransmissionCode::INVALID_ADDRESS);
+    }
+    if (length > kSubscriptionMaxLength) {
+        return static_cast<uint8_t>(EndTransmissionCode::DATA_TOO_LONG);
+    }
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    if (!_acquireToken()) {
+        return static_cast<uint8_t>(EndTransmissionCode::TIMEOUT);
+    }
+#endif
+    beginTransmission(address);
+    _out.write(reg);
+    _out.write(length);
+    _out.write(interval >> 8);
+    _out.write((uint8_t)interval);
+    _out.write(maxInterval >> 8);
+    _out.write((uint8_t)maxInterval);
+    return _endTransmission(CommandStringType::SUBSCRIBE, true);
+}
+
+#endif
+
 uint8_t SerialTwoWireMaster::_waitForResponse(uint8_t address, uint8_t count)
 {
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+    // extended by busy responses
+    _responseTimeout = millis() + _timeout;
+    _retryAfter = 0;
+    auto &timeout = _responseTimeout;
+#else
     unsigned long timeout = millis() + _timeout;
-    while(flags()._outIsFilling() && millis() <= timeout) {
-        optimistic_yield(1000);
-        _invokeOnReadSerial();
+#endif
+#if I2C_OVER_UART_ENABLE_RETRIES
+    _responseDiscarded = false;
+    while(flags()._requestIsFilling() && !_responseDiscarded && millis() <= timeout) {
+#else
+    while(flags()._requestIsFilling() && millis() <= timeout) {
+#endif
+        // the deadline is absolute and might have been extended by a busy response
+        auto now = millis();
+        _wait(now, timeout > now ? timeout - now : 0);
     }
-    __LDBG_printf("count=%u _ravail=%u _rlen=%u outs=%u", _request().charAt(0), _request().available(), _request().length(), flags()._outState);
-    if (flags()._getOutState() == OutStateType::FILLED && !_request().empty() && _request().read() == address) {
-        flags()._setOutState(OutStateType::NONE);
-        return count;
-     }
+    __LDBG_printf("count=%u _ravail=%u _rlen=%u outs=%u", _request().charAt(0), _request().available(), _request().length(), flags()._requestState);
+    if (flags()._getRequestState() == OutStateType::FILLED && !_request().empty() && _request().read() == address) {
+        if (_request().available() >= count) {
+            flags()._setRequestState(OutStateType::NONE);
+            return count;
+        }
+        // NACK or incomplete response
+#if I2C_OVER_UART_ENABLE_RETRIES
+        _retryStats._nacks++;
+#endif
+    }
+#if I2C_OVER_UART_ENABLE_RETRIES
+    else if (_responseDiscarded) {
+        _retryStats._corrupted++;
+    }
+    else {
+        _retryStats._timeouts++;
+    }
+#endif
      //PrintString str;
      //size_t len = _request().length();
      //size_t avail = _request().available();
@@ -97,7 +855,7 @@ uint8_t SerialTwoWireMaster::_waitForResponse(uint8_t address, uint8_t count)
      //__LDBG_printf("len=%u avail=%u data=%s", len, avail, str.c_str());
      // timeout, wrong address, wrong size...
     _request().clear();
-    flags()._setOutState(OutStateType::NONE);
+    flags()._setRequestState(OutStateType::NONE);
     return 0;
 }
 
@@ -120,18 +878,52 @@ void SerialTwoWireMaster::_newLine()
 {
     // add any data that's left in the buffer
     _addBuffer(_parseData(true));
+#if I2C_OVER_UART_ENABLE_FEC
+    if (_fecCorrect()) {
+        for(uint8_t i = 0; i < _fecLength && flags()._getCommand() > CommandType::DISCARD; i++) {
+            _addBuffer(_fecBuffer[i]);
+        }
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+    if (flags()._compressed && !_decoder.isComplete()) {
+        __LDBG_printf("discard incomplete compressed data ilen=%u", _in.length());
+        _discard();
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    if (flags()._sequenced && flags()._getCommand() > CommandType::DISCARD && flags()._inState) {
+        _receiveSequenced(0);
+    }
+#endif
 
     __LDBG_printf("cmd=%s len=%u ilen=%u rlen=%u discard=%u outs=%u ins=%u",
         flags()._getCommandAsString().c_str(), data()._length, _in.length(),
-        (flags()._getOutState() == OutStateType::FILLING ? _request().length() : 0),
-        (flags()._getCommand() <= CommandType::DISCARD || (_in.length() == 0 && flags()._outIsFilling() == false)),
-        flags()._outState,
+        (flags()._getRequestState() == OutStateType::FILLING ? _request().length() : 0),
+        (flags()._getCommand() <= CommandType::DISCARD || (_in.length() == 0 && flags()._requestIsFilling() == false)),
+        flags()._requestState,
         flags()._inState
     );
 
-    if (flags()._getCommand() > CommandType::DISCARD && (flags()._inState || flags()._outIsFilling())) {
+    if (flags()._getCommand() > CommandType::DISCARD && (flags()._inState || flags()._requestIsFilling())) {
+        flags()._processing = true;
         _processData();
+        flags()._processing = false;
+    }
+    else if (flags()._getRequestState() == OutStateType::FILLING) {
+        // the response has been discarded, keep the address and wait for another one
+        while (_request().length() > 1) {
+            _request().pop_back();
+        }
+        flags()._setRequestState(OutStateType::FILL);
+#if I2C_OVER_UART_ENABLE_RETRIES
+        // retry without waiting for the timeout
+        _responseDiscarded = true;
+#endif
     }
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    _flowNewLine();
+#endif
     _cleanup();
 }
 
@@ -140,19 +932,25 @@ void SerialTwoWireMaster::_addBuffer(int byte)
     if (byte == kNoDataAvailable) {
         return;
     }
-    //__LDBG_printf("data=%02x _addr=%02x _request=%02x outs=%u _ravail=%u _rlen=%u", byte, data()._address, _request().charAt(0) & 0xffff, flags()._outState, _request().available(), _request().length());
-    if (flags()._getOutState() == OutStateType::FILLING) {
+    //__LDBG_printf("data=%02x _addr=%02x _request=%02x outs=%u _ravail=%u _rlen=%u", byte, data()._address, _request().charAt(0) & 0xffff, flags()._requestState, _request().available(), _request().length());
+    if (flags()._getRequestState() == OutStateType::FILLING) {
         if (_request().length() >= kTransmissionMaxLength) {
             __LDBG_printf("data=%d rlen=%u max=%u", byte, _request().length(), kTransmissionMaxLength);
             _discard();
         }
         else {
-            // __LDBG_printf("data=%u outs=%u avail=%u len=%u", byte, flags()._outState, _request().available(), _request().length());
+            // __LDBG_printf("data=%u outs=%u avail=%u len=%u", byte, flags()._requestState, _request().available(), _request().length());
             _request().write(byte);
         }
     }
     else if (flags()._inState) {
         // write to _in
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+        if (flags()._compressed) {
+            _addCompressed(byte, kTransmissionMaxLength);
+        }
+        else
+#endif
         if (flags()._getCommand() == CommandType::MASTER_REQUEST && _in.length() >= kRequestTransmissionMaxLength) {
             __LDBG_printf("data=%d ilen=%u max=%u", byte, _in.length(), kRequestTransmissionMaxLength);
             _discard();
@@ -167,10 +965,63 @@ void SerialTwoWireMaster::_addBuffer(int byte)
     }
     else {
         __LDBG_assertf(_in.length() == 0, "len=%u data=%d cmd=%s", data()._length, byte, data()._getCommandAsString().c_str());
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+        if (data()._getCommand() == CommandType::SLAVE_PUSH) {
+            // pushed values are accepted from any address
+            _in.write(byte);
+            flags()._inState = true;
+        }
+        else
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+        if (data()._getCommand() == CommandType::NEGOTIATE) {
+            // accepted from any address
+            _in.write(byte);
+            flags()._inState = true;
+        }
+        else
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+        if (data()._getCommand() == CommandType::FLOW_CONTROL) {
+            // credits are accepted from any address
+            _in.write(byte);
+            flags()._inState = true;
+        }
+        else
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+        if (data()._getCommand() == CommandType::ACKNOWLEDGE) {
+            // accepted from any address
+            _in.write(byte);
+            flags()._inState = true;
+        }
+        else
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+        if (data()._getCommand() == CommandType::TOKEN) {
+            // tokens passed to other masters are processed too
+            _in.write(byte);
+            flags()._inState = true;
+        }
+        else
+#endif
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+        if (data()._getCommand() == CommandType::SLAVE_BUSY) {
+            if (_request().length() == 1 && flags()._getRequestState() == OutStateType::FILL && _request()[0] == byte) {
+                _in.write(byte);
+                flags()._inState = true;
+            }
+            else {
+                // not waiting for this address
+                _discard();
+            }
+        }
+        else
+#endif
         if (byte == data()._address) {
             if (data()._getCommand() == CommandType::SLAVE_RESPONSE) {
                 // discard response from own address
-                __LDBG_printf("addr=%02x _addr=%02x _request=%02x outs=%u", byte, data()._address, _request().charAt(0) & 0xffff, (int)flags()._outState);
+                __LDBG_printf("addr=%02x _addr=%02x _request=%02x outs=%u", byte, data()._address, _request().charAt(0) & 0xffff, (int)flags()._requestState);
                 _discard();
             }
             else {
@@ -178,16 +1029,30 @@ void SerialTwoWireMaster::_addBuffer(int byte)
                 flags()._inState = true;
             }
         }
-        else if (_request().length() == 1 && flags()._getOutState() == OutStateType::FILL && _request()[0] == byte) {
+#if I2C_OVER_UART_ENABLE_SCHEDULER
+        else if (data()._getCommand() == CommandType::SLAVE_RESPONSE && _findPendingSchedule(byte) != kInvalidSchedule) {
+            // scheduled reads have been sent before any request of requestFrom()
+            _in.write(byte);
+            flags()._inState = true;
+        }
+#endif
+        else if (_request().length() == 1 && flags()._getRequestState() == OutStateType::FILL && _request()[0] == byte && data()._getCommand() == CommandType::SLAVE_RESPONSE) {
             // mark as being processed
-            flags()._setOutState(OutStateType::FILLING);
+            flags()._setRequestState(OutStateType::FILLING);
             // the address was added by requestFrom() already
             // keep it int the buffer for waitForResponse
-            __LDBG_printf("addr=%02x outs=%u ravail=%u rlen=%u", _request()[0], flags()._outState, _request().available(), _request().length());
+            __LDBG_printf("addr=%02x outs=%u ravail=%u rlen=%u", _request()[0], flags()._requestState, _request().available(), _request().length());
+        }
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+        else if (data()._getCommand() == CommandType::SLAVE_RESPONSE && byte >= kProgramAddress && byte < kProgramAddress + kProgramSlots) {
+            // results of a repeated program
+            _in.write(byte);
+            flags()._inState = true;
         }
+#endif
         else {
             // discard data from invalid address
-            __LDBG_printf("addr=%02x _addr=%02x _request=%02x outs=%u", byte, data()._address, _request().charAt(0) & 0xffff, flags()._outState);
+            __LDBG_printf("addr=%02x _addr=%02x _request=%02x outs=%u", byte, data()._address, _request().charAt(0) & 0xffff, flags()._requestState);
             _discard();
         }
     }
@@ -200,34 +1065,93 @@ void SerialTwoWireMaster::_processData()
 
     switch (flags()._getCommand()) {
     case CommandType::MASTER_REQUEST:
-        if (true) {
-            // request has address and length only
-            __LDBG_printf("requestFrom addr=%02x len=%u", data()._address, _in.charAt(0));
-            _in.clear();
-            if (flags()._getOutState() != OutStateType::NONE) {
-                // cannot accept request while requestFrom() is waiting
-                _sendNack(data()._getAddress());
-                return;
+        _processRequest(data()._getAddress());
+        break;
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    case CommandType::TOKEN:
+        if (flags()._inState) {
+            _processToken();
+        }
+        break;
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    case CommandType::FLOW_CONTROL:
+        _processCredits();
+        break;
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    case CommandType::NEGOTIATE:
+        _processNegotiation();
+        break;
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    case CommandType::ACKNOWLEDGE:
+        _processAcknowledgement();
+        break;
+#endif
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+    case CommandType::COMMAND:
+        _invokeOnCommand();
+        break;
+#endif
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+    case CommandType::SLAVE_BUSY:
+        if (flags()._inState && _in.length() == 3 && flags()._requestIsFilling()) {
+            _retryAfter = (_in[1] << 8) | _in[2];
+            auto timeout = millis() + _retryAfter;
+            if (timeout > _responseTimeout) {
+                _responseTimeout = timeout;
             }
-            beginTransmission(data()._getAddress());
-            // collect data in output buffer
-            _invokeOnRequest();
-            _endTransmission(CommandStringType::SLAVE_RESPONSE, true);
+            __LDBG_printf("busy addr=%02x retry_after=%u", _in[0], _retryAfter);
         }
         break;
+#endif
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+    case CommandType::SUBSCRIBE:
+        if (flags()._inState) {
+            _subscribe(data()._getAddress());
+        }
+        break;
+    case CommandType::SLAVE_PUSH:
+#endif
     case CommandType::SLAVE_RESPONSE:
     case CommandType::MASTER_TRANSMIT:
         if (flags()._inState) {
             __LDBG_assertf(_in.length() == _in.available(), "ilen=%u iavail=%u", _in.length(), _in.available());
             __LDBG_printf("iavail=%u ilen=%u _addr=%02x", _in.available(), _in.length(), data()._address);
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+            if (flags()._getCommand() == CommandType::SLAVE_PUSH) {
+                _invokeOnPush();
+                return;
+            }
+#endif
+#if I2C_OVER_UART_ENABLE_SCHEDULER
+            if (flags()._getCommand() == CommandType::SLAVE_RESPONSE) {
+                auto id = _findPendingSchedule(_in.peek());
+                if (id != kInvalidSchedule) {
+                    _in.read();
+                    auto length = _in.available();
+                    _schedule[id]._pending = false;
+                    _scheduleStats._responses++;
+                    _invokeOnScheduledRead(id, static_cast<uint8_t>(length == _schedule[id]._length ? EndTransmissionCode::SUCCESS : length ? EndTransmissionCode::NACK_ON_DATA : EndTransmissionCode::NACK_ON_ADDRESS), length);
+                    return;
+                }
+            }
+#endif
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+            if (flags()._getCommand() == CommandType::SLAVE_RESPONSE) {
+                _invokeOnProgramResult();
+                return;
+            }
+#endif
             _invokeOnReceive(_in.available());
             return;
         }
-        if (flags()._getOutState() == OutStateType::FILLING) {
+        if (flags()._getRequestState() == OutStateType::FILLING) {
             __LDBG_assertf(_request().length() == _request().available(), "rlen=%u ravail=%u", _request().length(), _request().available());
             // mark as finished
-            flags()._setOutState(OutStateType::FILLED);
-            __LDBG_printf("addr=%02x ravail=%u outs=%u", _request().peek(), _request().available(), flags()._outState);
+            flags()._setRequestState(OutStateType::FILLED);
+            __LDBG_printf("addr=%02x ravail=%u outs=%u", _request().peek(), _request().available(), flags()._requestState);
         }
         break;
     default:
@@ -239,6 +1163,12 @@ void SerialTwoWireMaster::_processData()
 
 void SerialTwoWireMaster::feed(uint8_t byte)
 {
+#if I2C_OVER_UART_ENABLE_RESYNC
+    _resync(byte);
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    _flowLineLength++;
+#endif
     // tmpstr.printf_P(PSTR("%c"), byte);
     if (byte == '\n') { // check first
         // __DBG_printf("%s", tmpstr.c_str());
@@ -247,10 +1177,16 @@ void SerialTwoWireMaster::feed(uint8_t byte)
     }
     else if (flags()._getCommand() == CommandType::DISCARD || byte == '\r') {
         // skip rest of the line cause of invalid data
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+        _forwardUnknownLine(byte);
+#endif
     }
     else if (flags()._getCommand() == CommandType::NONE) {
         static_assert(kCommandMaxLength < sizeof(_buffer), "invalid size");
         if ((data()._length == 0 && byte != '+') || data()._length >= kCommandMaxLength) {
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+            _beginUnknownLine(byte);
+#endif
             data()._length = 0;
             _discard();
         }
@@ -261,7 +1197,7 @@ void SerialTwoWireMaster::feed(uint8_t byte)
             switch(getCommandStringType(_buffer)) {
                 case CommandStringType::MASTER_TRANSMIT:
 #if I2C_OVER_UART_SLAVE_RESPONSE_MASTER_TRANSMIT
-                    flags()._setCommand(flags()._outIsFilling() ? CommandType::SLAVE_RESPONSE : CommandType::MASTER_TRANSMIT);
+                    flags()._setCommand(flags()._requestIsFilling() ? CommandType::SLAVE_RESPONSE : CommandType::MASTER_TRANSMIT);
 #else
                     flags()._setCommand(CommandType::MASTER_TRANSMIT);
 #endif
@@ -273,6 +1209,67 @@ void SerialTwoWireMaster::feed(uint8_t byte)
                     data()._length = 0;
                     _newTransmission();
                     break;
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+                case CommandStringType::COMPRESSED_TRANSMIT:
+                    flags()._setCommand(CommandType::MASTER_TRANSMIT);
+                    data()._length = 0;
+                    _newTransmission();
+                    _beginCompressed();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+                case CommandStringType::SEQUENCED_TRANSMIT:
+                    flags()._setCommand(CommandType::MASTER_TRANSMIT);
+                    flags()._sequenced = true;
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+                case CommandStringType::ACKNOWLEDGE:
+                    flags()._setCommand(CommandType::ACKNOWLEDGE);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+                case CommandStringType::SUBSCRIBE:
+                    flags()._setCommand(CommandType::SUBSCRIBE);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+                case CommandStringType::SLAVE_PUSH:
+                    flags()._setCommand(CommandType::SLAVE_PUSH);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+                case CommandStringType::SLAVE_BUSY:
+                    flags()._setCommand(CommandType::SLAVE_BUSY);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+                case CommandStringType::TOKEN:
+                    flags()._setCommand(CommandType::TOKEN);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+                case CommandStringType::FLOW_CONTROL:
+                    flags()._setCommand(CommandType::FLOW_CONTROL);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+                case CommandStringType::NEGOTIATE:
+                    flags()._setCommand(CommandType::NEGOTIATE);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
 #if !I2C_OVER_UART_SLAVE_RESPONSE_MASTER_TRANSMIT
                 case CommandStringType::SLAVE_RESPONSE:
                     flags()._setCommand(CommandType::SLAVE_RESPONSE);
@@ -280,7 +1277,19 @@ void SerialTwoWireMaster::feed(uint8_t byte)
                     _newTransmission();
                     break;
 #endif
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+                case CommandStringType::PROGRAM:
+                case CommandStringType::RUN_PROGRAM:
+#endif
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+                case CommandStringType::MULTI_READ:
+#endif
+                    // executed by SerialTwoWireBridge
+                    break;
                 case CommandStringType::NONE:
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+                    _findCommandHandler();
+#endif
                     break;
             }
         }
@@ -297,9 +1306,16 @@ void SerialTwoWireMaster::feed(uint8_t byte)
         _addBuffer(_parseData());
     }
     else if (byte != ',' && !isspace(byte)) {
+#if I2C_OVER_UART_ENABLE_FEC
+        // probably a corrupted digit, replace it and let the FEC correct the byte
+        __LDBG_printf("replace data=%u", byte);
+        _buffer[data()._length++] = '0';
+        _addBuffer(_parseData());
+#else
         // invalid data, discard
         __LDBG_printf("discard data=%u", byte);
         _discard();
         data()._length = 0;
+#endif
     }
 }
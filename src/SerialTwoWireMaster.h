@@ -5,6 +5,8 @@
 #pragma once
 
 #include "SerialTwoWireSlave.h"
+#include "SerialTwoWireReadCache.h"
+#include "SerialTwoWireQueue.h"
 #include "SerialTwoWireDebug.h"
 
 #if DEBUG_SERIALTWOWIRE
@@ -19,8 +21,79 @@ public:
     using SerialTwoWireSlave::begin;
     using Stream::setTimeout;
 
+#if I2C_OVER_UART_ENABLE_RETRIES
+    struct RetryStats {
+        uint32_t _requests;
+        uint32_t _retries;
+        uint32_t _timeouts;                 // no response
+        uint32_t _nacks;                    // response without data
+        uint32_t _corrupted;                // response discarded, invalid data or CRC
+        uint32_t _failed;                   // no valid response after the last retry
+
+        RetryStats() : _requests(0), _retries(0), _timeouts(0), _nacks(0), _corrupted(0), _failed(0) {}
+    };
+
+    static constexpr uint8_t kRetryPointerLength = I2C_OVER_UART_RETRY_POINTER_LENGTH;
+#endif
+
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    static constexpr uint8_t kTokenRingMaxSize = I2C_OVER_UART_TOKEN_RING_MAX_SIZE;
+
+    struct TokenStats {
+        uint32_t _received;
+        uint32_t _passed;
+        uint32_t _regenerated;              // lost token
+        uint32_t _dropped;                  // duplicate token
+
+        TokenStats() : _received(0), _passed(0), _regenerated(0), _dropped(0) {}
+    };
+#endif
+
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+#if I2C_OVER_UART_USE_STD_FUNCTION
+    using onProgramResultCallback = std::function<void(uint8_t, uint8_t, int)>;
+#else
+    typedef void (*onProgramResultCallback)(uint8_t slot, uint8_t status, int length);
+#endif
+#endif
+
+#if I2C_OVER_UART_ENABLE_SCHEDULER
+    static constexpr uint8_t kScheduleSlots = I2C_OVER_UART_SCHEDULE_SLOTS;
+    static constexpr uint8_t kSchedulePipeline = I2C_OVER_UART_SCHEDULE_PIPELINE;
+    static constexpr uint8_t kInvalidSchedule = 0xff;
+
+    struct ScheduleStats {
+        uint32_t _requests;
+        uint32_t _responses;
+        uint32_t _timeouts;
+        uint32_t _missed;                   // periods skipped because the previous request was late
+        uint32_t _maxJitter;                // max. delay in milliseconds between due and sent
+        uint32_t _totalJitter;              // average is _totalJitter / _requests
+
+        ScheduleStats() : _requests(0), _responses(0), _timeouts(0), _missed(0), _maxJitter(0), _totalJitter(0) {}
+    };
+
+#if I2C_OVER_UART_USE_STD_FUNCTION
+    using onScheduledReadCallback = std::function<void(uint8_t, uint8_t, int)>;
+#else
+    typedef void (*onScheduledReadCallback)(uint8_t id, uint8_t status, int length);
+#endif
+#endif
+
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+#if I2C_OVER_UART_USE_STD_FUNCTION
+    using onPushCallback = std::function<void(uint8_t, uint8_t, int)>;
+#else
+    typedef void (*onPushCallback)(uint8_t address, uint8_t reg, int length);
+#endif
+#endif
+
 public:
     void begin();
+    void end();
+
+    void setAllocMinSize(uint8_t size);
+    void releaseBuffers();
 
     // use setTimeout() to change the default timeout. default is set by the Stream class
     // and usually is 1000 milliseconds. the timeout is for receiving the complete the transmissions
@@ -28,6 +101,123 @@ public:
     uint8_t requestFrom(uint8_t address, uint8_t count, uint8_t stop = true);
     inline uint8_t requestFrom(int address, int count, int stop = true);
 
+    // writing the register pointer to an address with a read cache TTL is deferred until the
+    // next request that is not answered from the cache. if the next call is not requestFrom()
+    // for the same address, the register pointer is sent by the next endTransmission() or
+    // poll(). if the token ring is enabled, it waits for the token and returns TIMEOUT if it
+    // has not been received within the timeout
+    uint8_t endTransmission(uint8_t stop = true);
+
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+    // cache responses from address for ttl milliseconds. 0 disables the cache for the address
+    // returns false if I2C_OVER_UART_READ_CACHE_ADDRESSES is exceeded
+    bool setReadCacheTTL(uint8_t address, uint16_t ttl);
+    void invalidateReadCache(uint8_t address);
+    void clearReadCache();
+    const SerialTwoWireReadCache::Stats &getReadCacheStats() const;
+#endif
+
+#if I2C_OVER_UART_ENABLE_RETRIES
+    // number of retries if requestFrom() times out or receives an invalid response. the delay before
+    // retrying starts at backoff milliseconds, doubles with each retry up to maxBackoff and is
+    // randomized between 50 and 100% to avoid repeated collisions. the timeout applies to each attempt.
+    // the last transmission to the address is sent again before each retry if it is not longer
+    // than I2C_OVER_UART_RETRY_POINTER_LENGTH, otherwise the request is not retried
+    void setRetries(uint8_t retries, uint16_t backoff = I2C_OVER_UART_RETRY_BACKOFF, uint16_t maxBackoff = I2C_OVER_UART_RETRY_MAX_BACKOFF);
+    const RetryStats &getRetryStats() const;
+    void resetRetryStats();
+#endif
+
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    // masters sharing the serial line pass a token in the order of their addresses and only
+    // the master holding the token starts transmissions and requests. each master must have its
+    // own address set with begin(address) and call poll() inside loop(). the token is held for
+    // holdTime milliseconds and regenerated if it has not been seen for timeout milliseconds
+    // count = 0 disables the token ring
+    bool setTokenRing(const uint8_t *masters, uint8_t count, uint16_t holdTime = I2C_OVER_UART_TOKEN_HOLD_TIME, uint16_t timeout = I2C_OVER_UART_TOKEN_TIMEOUT);
+    bool hasToken() const;
+    const TokenStats &getTokenStats() const;
+#endif
+
+#if I2C_OVER_UART_ENABLE_SCHEDULER
+    // read length bytes from register reg every interval milliseconds. the reads are spread over
+    // the interval and sent by poll() without waiting for the response. the results are received
+    // with the onScheduledRead callback and can be read inside the callback. returns the id
+    // or kInvalidSchedule if no slot is available
+    uint8_t addSchedule(uint8_t address, uint8_t reg, uint8_t length, uint16_t interval);
+    void removeSchedule(uint8_t id);
+    void onScheduledRead(onScheduledReadCallback callback);
+    const ScheduleStats &getScheduleStats() const;
+    void resetScheduleStats();
+#endif
+
+#if I2C_OVER_UART_ENABLE_QUEUE
+    // transmissions are queued by endTransmission() and sent by poll() if they fit into the
+    // transmit buffer of the serial port. priority 0 is sent first, addresses with the same
+    // priority are served round robin. returns false if I2C_OVER_UART_QUEUE_ADDRESSES is exceeded
+    bool setPriority(uint8_t address, uint8_t priority);
+    // limit transmissions to address to rate bytes per second with bursts up to burst bytes
+    // rate 0 removes the limit
+    bool setRateLimit(uint8_t address, uint16_t rate, uint16_t burst);
+    // for addresses with idempotent registers. a transmission replaces any queued transmission
+    // to the same register that has not been sent yet
+    bool setCoalescing(uint8_t address, bool enable);
+    // send all queued transmissions ignoring the rate limits
+    void flushQueue();
+    const SerialTwoWireQueue::Stats &getQueueStats() const;
+#endif
+
+#if I2C_OVER_UART_ENABLE_TOKEN_RING || I2C_OVER_UART_ENABLE_SCHEDULER || I2C_OVER_UART_ENABLE_QUEUE || I2C_OVER_UART_ENABLE_READ_CACHE
+    void poll();
+#endif
+
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    // exchange capabilities with the other side and switch both to baudRate if not 0. if the
+    // new baud rate cannot be confirmed, both sides fall back to the previous baud rate. the
+    // I2C clock of the other side is set to clock if not 0. returns OTHER if the framing
+    // features do not match
+    uint8_t negotiate(uint32_t baudRate = 0, uint32_t clock = 0);
+    // set the I2C clock of the other side, for example the I2C bus of a bridge
+    void setClock(uint32_t clock);
+#endif
+
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+    // retry after hint in milliseconds of the last busy response received by requestFrom()
+    uint16_t getRetryAfter() const;
+#endif
+
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+    // subscribe to length bytes from register reg. the slave checks the value every interval
+    // milliseconds and pushes it if it has changed or maxInterval has elapsed. 0 pushes changes
+    // only. the value is read inside the onPush callback
+    uint8_t subscribe(uint8_t address, uint8_t reg, uint8_t length, uint16_t interval, uint16_t maxInterval = 0);
+    uint8_t unsubscribe(uint8_t address, uint8_t reg);
+
+    void onPush(onPushCallback callback);
+#endif
+
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+    // upload a program to the bridge. the program is a sequence of ProgramOpcode followed
+    // by their arguments. length 0 deletes the program
+    uint8_t uploadProgram(uint8_t slot, const uint8_t *program, uint8_t length);
+    // run the program and wait for the results. length is the number of bytes read by the
+    // program. returns length or 0 on timeout. the data is read like after requestFrom()
+    uint8_t runProgram(uint8_t slot, uint8_t length);
+    // status of the last runProgram(), 0 for success or the error of the first failed step
+    uint8_t getProgramStatus() const;
+    // run the program every interval milliseconds, 0 stops it. the results are received with
+    // the onProgramResult callback and can be read inside the callback
+    uint8_t repeatProgram(uint8_t slot, uint16_t interval);
+    void onProgramResult(onProgramResultCallback callback);
+#endif
+
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+    // read from multiple devices or registers with a single request to the bridge. the register
+    // is written before reading _length byte into _data. _status is set for each item. returns
+    // the number of successful reads, 0 on timeout
+    uint8_t readMultiple(MultiRead_t *items, uint8_t count);
+#endif
+
     size_t available() const;
     size_t isAvailable();
     int readByte();
@@ -66,12 +256,56 @@ public:
     // this method must not be called from inside an ISR or reading serial data might be blocked
     // leading to read timeouts and blocking the ISR for the maximum timeout
     virtual void feed(uint8_t data);
+#if I2C_OVER_UART_ENABLE_RX_RING
+    using SerialTwoWireSlave::feed;
+#endif
 
 protected:
+#if I2C_OVER_UART_ENABLE_RESYNC
+    virtual void _newLine() override;
+#else
     void _newLine();
+#endif
     void _addBuffer(int data);
     void _processData();
+    uint8_t _sendRequest(uint8_t address, uint8_t count);
     uint8_t _waitForResponse(uint8_t address, uint8_t count);
+    bool _writeRequest(uint8_t address, uint8_t count);
+#if I2C_OVER_UART_ENABLE_RETRIES
+    void _backoff(uint8_t retry);
+#endif
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+    // sends a register pointer deferred by endTransmission() unless it belongs to except
+    uint8_t _sendPendingRegister(uint8_t except = SerialTwoWireReadCache::kUnused);
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+    bool _acquireToken();
+    void _passToken();
+    void _checkTokenTimeout();
+    void _processToken();
+#endif
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+    void _invokeOnPush();
+#endif
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+    void _invokeOnProgramResult();
+#endif
+#if I2C_OVER_UART_ENABLE_QUEUE
+    bool _queueTransmission();
+    // wait blocks until the frame has been sent. if limits is true, it waits for the rate limit
+    bool _sendQueued(uint8_t address, bool wait, bool limits = true);
+    void _pollQueue();
+    void _flushQueue(uint8_t address);
+#endif
+#if I2C_OVER_UART_ENABLE_SCHEDULER
+    void _pollSchedule();
+    void _sendScheduledRead(uint8_t id, uint32_t now);
+    uint8_t _findPendingSchedule(uint8_t address) const;
+    void _invokeOnScheduledRead(uint8_t id, uint8_t status, int length);
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    uint8_t _negotiate(NegotiationType type, uint32_t clock, uint32_t baudRate);
+#endif
 
 protected:
 #if DEBUG_SERIALTWOWIRE_ALL_PUBLIC
@@ -80,6 +314,76 @@ public:
     const SerialTwoWireStream &readFrom() const;
     SerialTwoWireStream &readFrom();
     SerialTwoWireStream &_request();
+
+protected:
+    // response for requestFrom(). _out is used for transmissions and responses to
+    // incoming requests, which can be served while requestFrom() is waiting
+    SerialTwoWireStream _response;
+
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+protected:
+    SerialTwoWireReadCache _readCache;
+#endif
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+protected:
+    onPushCallback _onPush = nullptr;
+#endif
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+protected:
+    onProgramResultCallback _onProgramResult = nullptr;
+    uint8_t _programStatus = 0;
+#endif
+#if I2C_OVER_UART_ENABLE_QUEUE
+protected:
+    SerialTwoWireQueue _queue;
+#endif
+#if I2C_OVER_UART_ENABLE_SCHEDULER
+protected:
+    struct Schedule_t {
+        uint16_t _interval;                 // 0 = unused
+        uint8_t _address;
+        uint8_t _register;
+        uint8_t _length;
+        bool _pending;                      // waiting for the response
+        uint32_t _due;
+        uint32_t _sent;
+    };
+
+    Schedule_t _schedule[kScheduleSlots] = {};
+    ScheduleStats _scheduleStats;
+    onScheduledReadCallback _onScheduledRead = nullptr;
+#endif
+#if I2C_OVER_UART_ENABLE_RETRIES
+protected:
+    RetryStats _retryStats;
+    uint16_t _retryBackoff = I2C_OVER_UART_RETRY_BACKOFF;
+    uint16_t _retryMaxBackoff = I2C_OVER_UART_RETRY_MAX_BACKOFF;
+    uint8_t _retries = I2C_OVER_UART_RETRIES;
+    bool _responseDiscarded = false;
+    // last transmission before the request, kNotInitializedAddress = none
+    struct RetryPointer_t {
+        uint8_t _address = kNotInitializedAddress;
+        uint8_t _length;                    // kRetryPointerLength + 1 = too long
+        uint8_t _data[kRetryPointerLength];
+    } _retryPointer;
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+protected:
+    TokenStats _tokenStats;
+    uint8_t _tokenRing[kTokenRingMaxSize];  // sorted
+    uint8_t _tokenRingSize = 0;
+    uint8_t _tokenPosition = 0;             // own index in _tokenRing
+    bool _hasToken = false;
+    uint16_t _tokenHoldTime = I2C_OVER_UART_TOKEN_HOLD_TIME;
+    uint16_t _tokenTimeout = I2C_OVER_UART_TOKEN_TIMEOUT;
+    uint32_t _tokenReceived = 0;
+    uint32_t _tokenLastSeen = 0;
+#endif
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+protected:
+    unsigned long _responseTimeout = 0;
+    uint16_t _retryAfter = 0;
+#endif
 };
 
 #include "SerialTwoWireMaster.hpp"
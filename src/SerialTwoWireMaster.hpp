@@ -15,6 +15,30 @@ inline void SerialTwoWireMaster::begin()
 {
     __LDBG_assertf(data()._address == kNotInitializedAddress, "begin called again without end");
     data()._address = kMasterAddress;
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    _retransmit.begin();
+#endif
+}
+
+inline void SerialTwoWireMaster::end()
+{
+    SerialTwoWireSlave::end();
+    _response.release();
+#if I2C_OVER_UART_ENABLE_QUEUE
+    _queue.clear();
+#endif
+}
+
+inline void SerialTwoWireMaster::setAllocMinSize(uint8_t size)
+{
+    SerialTwoWireSlave::setAllocMinSize(size);
+    _response.setAllocMinSize(size);
+}
+
+inline void SerialTwoWireMaster::releaseBuffers()
+{
+    SerialTwoWireSlave::releaseBuffers();
+    _response.release();
 }
 
 inline uint8_t SerialTwoWireMaster::requestFrom(int address, int count, int stop)
@@ -22,6 +46,216 @@ inline uint8_t SerialTwoWireMaster::requestFrom(int address, int count, int stop
     return requestFrom((uint8_t)address, (uint8_t)count, (uint8_t)stop);
 }
 
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+
+inline bool SerialTwoWireMaster::setReadCacheTTL(uint8_t address, uint16_t ttl)
+{
+    if (ttl == 0) {
+        _sendPendingRegister();
+    }
+    return _readCache.setTTL(address, ttl);
+}
+
+inline void SerialTwoWireMaster::invalidateReadCache(uint8_t address)
+{
+    _readCache.invalidate(address);
+}
+
+inline void SerialTwoWireMaster::clearReadCache()
+{
+    _readCache.clear();
+}
+
+inline const SerialTwoWireReadCache::Stats &SerialTwoWireMaster::getReadCacheStats() const
+{
+    return _readCache.getStats();
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_RETRIES
+
+inline void SerialTwoWireMaster::setRetries(uint8_t retries, uint16_t backoff, uint16_t maxBackoff)
+{
+    _retries = retries;
+    _retryBackoff = backoff;
+    _retryMaxBackoff = maxBackoff;
+}
+
+inline const SerialTwoWireMaster::RetryStats &SerialTwoWireMaster::getRetryStats() const
+{
+    return _retryStats;
+}
+
+inline void SerialTwoWireMaster::resetRetryStats()
+{
+    _retryStats = RetryStats();
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+
+inline bool SerialTwoWireMaster::hasToken() const
+{
+    return _hasToken;
+}
+
+inline const SerialTwoWireMaster::TokenStats &SerialTwoWireMaster::getTokenStats() const
+{
+    return _tokenStats;
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+
+inline uint16_t SerialTwoWireMaster::getRetryAfter() const
+{
+    return _retryAfter;
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+
+inline uint8_t SerialTwoWireMaster::unsubscribe(uint8_t address, uint8_t reg)
+{
+    return subscribe(address, reg, 0, 0, 0);
+}
+
+inline void SerialTwoWireMaster::onPush(onPushCallback callback)
+{
+    _onPush = callback;
+}
+
+inline void SerialTwoWireMaster::_invokeOnPush()
+{
+    // address and register are in front of the data
+    if (_onPush && _in.available() >= 2) {
+        auto address = (uint8_t)_in.read();
+        auto reg = (uint8_t)_in.read();
+        flags()._readFromOut = false;
+        _onPush(address, reg, _in.available());
+        flags()._readFromOut = true;
+    }
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_QUEUE
+
+inline bool SerialTwoWireMaster::setPriority(uint8_t address, uint8_t priority)
+{
+    return _queue.setPriority(address, priority);
+}
+
+inline bool SerialTwoWireMaster::setRateLimit(uint8_t address, uint16_t rate, uint16_t burst)
+{
+    return _queue.setRateLimit(address, rate, burst);
+}
+
+inline bool SerialTwoWireMaster::setCoalescing(uint8_t address, bool enable)
+{
+    return _queue.setCoalescing(address, enable);
+}
+
+inline void SerialTwoWireMaster::flushQueue()
+{
+    _flushQueue(SerialTwoWireQueue::kUnused);
+}
+
+inline const SerialTwoWireQueue::Stats &SerialTwoWireMaster::getQueueStats() const
+{
+    return _queue.getStats();
+}
+
+inline void SerialTwoWireMaster::_pollQueue()
+{
+    while (_sendQueued(SerialTwoWireQueue::kUnused, false)) {
+    }
+}
+
+inline void SerialTwoWireMaster::_flushQueue(uint8_t address)
+{
+    while (_sendQueued(address, true, false)) {
+    }
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_SCHEDULER
+
+inline void SerialTwoWireMaster::removeSchedule(uint8_t id)
+{
+    if (id < kScheduleSlots) {
+        _schedule[id]._interval = 0;
+        _schedule[id]._pending = false;
+    }
+}
+
+inline void SerialTwoWireMaster::onScheduledRead(onScheduledReadCallback callback)
+{
+    _onScheduledRead = callback;
+}
+
+inline const SerialTwoWireMaster::ScheduleStats &SerialTwoWireMaster::getScheduleStats() const
+{
+    return _scheduleStats;
+}
+
+inline void SerialTwoWireMaster::resetScheduleStats()
+{
+    _scheduleStats = ScheduleStats();
+}
+
+inline uint8_t SerialTwoWireMaster::_findPendingSchedule(uint8_t address) const
+{
+    for(uint8_t id = 0; id < kScheduleSlots; id++) {
+        if (_schedule[id]._pending && _schedule[id]._address == address) {
+            return id;
+        }
+    }
+    return kInvalidSchedule;
+}
+
+inline void SerialTwoWireMaster::_invokeOnScheduledRead(uint8_t id, uint8_t status, int length)
+{
+    if (_onScheduledRead) {
+        flags()._readFromOut = false;
+        _onScheduledRead(id, status, length);
+        flags()._readFromOut = true;
+    }
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+
+inline uint8_t SerialTwoWireMaster::getProgramStatus() const
+{
+    return _programStatus;
+}
+
+inline void SerialTwoWireMaster::onProgramResult(onProgramResultCallback callback)
+{
+    _onProgramResult = callback;
+}
+
+inline void SerialTwoWireMaster::_invokeOnProgramResult()
+{
+    // address and status are in front of the data
+    if (_onProgramResult && _in.available() >= 2) {
+        auto slot = (uint8_t)(_in.read() - kProgramAddress);
+        auto status = (uint8_t)_in.read();
+        flags()._readFromOut = false;
+        _onProgramResult(slot, status, _in.available());
+        flags()._readFromOut = true;
+    }
+}
+
+#endif
+
 inline size_t SerialTwoWireMaster::available() const
 {
     return readFrom().available();
@@ -52,19 +286,28 @@ inline size_t SerialTwoWireMaster::read(char *data, size_t length)
     return read(reinterpret_cast<uint8_t *>(data), length);
 }
 
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+
+inline void SerialTwoWireMaster::setClock(uint32_t clock)
+{
+    negotiate(0, clock);
+}
+
+#endif
+
 inline const SerialTwoWireStream &SerialTwoWireMaster::readFrom() const
 {
-    return _data._readFromOut ? _out : _in;
+    return _data._readFromOut ? _response : _in;
 }
 
 inline SerialTwoWireStream &SerialTwoWireMaster::readFrom()
 {
-    return _data._readFromOut ? _out : _in;
+    return _data._readFromOut ? _response : _in;
 }
 
 inline SerialTwoWireStream &SerialTwoWireMaster::_request()
 {
-    return _out;
+    return _response;
 }
 
 #if DEBUG_SERIALTWOWIRE
@@ -0,0 +1,198 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWireQueue.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_QUEUE
+
+bool SerialTwoWireQueue::setPriority(uint8_t address, uint8_t priority)
+{
+    if (priority >= kPriorities) {
+        priority = kPriorities - 1;
+    }
+    auto ptr = _add(address);
+    if (!ptr) {
+        return false;
+    }
+    ptr->_priority = priority;
+    return true;
+}
+
+bool SerialTwoWireQueue::setRateLimit(uint8_t address, uint16_t rate, uint16_t burst)
+{
+    auto ptr = _add(address);
+    if (!ptr) {
+        return false;
+    }
+    ptr->_limit.setRateLimit(rate, burst);
+    return true;
+}
+
+bool SerialTwoWireQueue::setCoalescing(uint8_t address, bool enable)
+{
+    auto ptr = _add(address);
+    if (!ptr) {
+        return false;
+    }
+    ptr->_coalesce = enable;
+    return true;
+}
+
+bool SerialTwoWireQueue::push(const uint8_t *frame, uint8_t length)
+{
+    auto address = _find(frame[0]);
+    if (address && address->_coalesce && length > 1 && _coalesce(frame, length)) {
+        _stats._queued++;
+        return true;
+    }
+    if (length == 0 || !fits(length)) {
+        _stats._full++;
+        return false;
+    }
+    auto ptr = &_buffer[_length];
+    uint16_t time = millis();
+    *ptr++ = length;
+    *ptr++ = time;
+    *ptr++ = time >> 8;
+    memcpy(ptr, frame, length);
+    _length += kHeaderSize + length;
+    _stats._queued++;
+    return true;
+}
+
+const uint8_t *SerialTwoWireQueue::next(uint8_t &length, uint8_t address, bool limits)
+{
+    auto now = millis();
+    const uint8_t *result = nullptr;
+    uint8_t resultPriority = kPriorities;
+    uint8_t resultDistance = 0;
+    // only the oldest frame of each address can be sent
+    uint8_t seen[128 / 8] = {};
+    for(uint16_t pos = 0; pos < _length; pos += kHeaderSize + _buffer[pos]) {
+        auto frame = &_buffer[pos + kHeaderSize];
+        auto frameAddress = frame[0];
+        if (address != kUnused) {
+            if (frameAddress == address) {
+                length = _buffer[pos];
+                return frame;
+            }
+            continue;
+        }
+        auto &bit = seen[(frameAddress >> 3) & 0x0f];
+        auto mask = 1 << (frameAddress & 7);
+        if (bit & mask) {
+            continue;
+        }
+        bit |= mask;
+        auto ptr = _find(frameAddress);
+        auto priority = ptr ? ptr->_priority : kDefaultPriority;
+        if (priority > resultPriority || (limits && ptr && !ptr->_limit.isAllowed(_buffer[pos], now))) {
+            continue;
+        }
+        // round robin, the address following the last one that has been served wins
+        uint8_t distance = frameAddress - _lastAddress - 1;
+        if (priority < resultPriority || distance < resultDistance) {
+            result = frame;
+            resultPriority = priority;
+            resultDistance = distance;
+            length = _buffer[pos];
+        }
+    }
+    return result;
+}
+
+void SerialTwoWireQueue::pop(const uint8_t *frame)
+{
+    auto pos = _getPosition(frame);
+    auto length = _buffer[pos];
+    auto ptr = _find(frame[0]);
+    auto priority = ptr ? ptr->_priority : kDefaultPriority;
+    uint16_t latency = (uint16_t)millis() - (_buffer[pos + 1] | (_buffer[pos + 2] << 8));
+    if (latency > _stats._maxLatency[priority]) {
+        _stats._maxLatency[priority] = latency;
+    }
+    if (ptr) {
+        ptr->_limit.consume(length);
+    }
+    _lastAddress = frame[0];
+    _stats._sent++;
+    _remove(pos);
+}
+
+bool SerialTwoWireQueue::contains(uint8_t address) const
+{
+    for(uint16_t pos = 0; pos < _length; pos += kHeaderSize + _buffer[pos]) {
+        if (_buffer[pos + kHeaderSize] == address) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SerialTwoWireQueue::_remove(uint16_t pos)
+{
+    auto size = kHeaderSize + _buffer[pos];
+    _length -= size;
+    memmove(&_buffer[pos], &_buffer[pos + size], _length - pos);
+}
+
+bool SerialTwoWireQueue::_coalesce(const uint8_t *frame, uint8_t length)
+{
+    // the last frame with the same length is replaced in place to keep the order of writes
+    // to different registers
+    uint16_t replace = kSize;
+    for(uint16_t pos = 0; pos < _length; pos += kHeaderSize + _buffer[pos]) {
+        auto ptr = &_buffer[pos];
+        if (ptr[kHeaderSize] == frame[0] && ptr[0] == length && ptr[kHeaderSize + 1] == frame[1]) {
+            replace = pos;
+        }
+    }
+    uint16_t pos = 0;
+    while (pos < _length) {
+        auto ptr = &_buffer[pos];
+        uint16_t size = kHeaderSize + ptr[0];
+        if (ptr[kHeaderSize] == frame[0] && ptr[0] > 1 && ptr[0] <= length && ptr[kHeaderSize + 1] == frame[1]) {
+            __LDBG_printf("addr=%02x reg=%02x len=%u", frame[0], frame[1], ptr[0]);
+            _stats._coalesced++;
+            if (pos == replace) {
+                memcpy(&ptr[kHeaderSize], frame, length);
+                pos += size;
+                continue;
+            }
+            _remove(pos);
+            if (replace != kSize && replace > pos) {
+                replace -= size;
+            }
+        }
+        else {
+            pos += size;
+        }
+    }
+    return replace != kSize;
+}
+
+SerialTwoWireQueue::Address_t *SerialTwoWireQueue::_add(uint8_t address)
+{
+    auto ptr = _find(address);
+    if (!ptr) {
+        ptr = _find(kUnused);
+        if (!ptr) {
+            __LDBG_printf("addr=%02x no free slot", address);
+            return nullptr;
+        }
+        ptr->_address = address;
+        ptr->_priority = kDefaultPriority;
+        ptr->_coalesce = false;
+        ptr->_limit.setRateLimit(0, 0);
+    }
+    return ptr;
+}
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+#include "SerialTwoWireTokenBucket.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+using namespace SerialTwoWireDef;
+
+#if I2C_OVER_UART_ENABLE_QUEUE
+
+//
+// Transmission queue for SerialTwoWireMaster
+//
+// frames are stored in a static buffer as length, time and the transmission including
+// the address. frames of the same address are sent in the order they have been queued
+//
+// the next frame is the oldest frame of the address with the highest priority. addresses
+// with the same priority are served round robin. an address can be limited to a number of
+// bytes per second with a token bucket, frames that exceed the limit are kept in the queue
+// and frames of other addresses are sent instead
+//
+// addresses with idempotent registers can enable coalescing. a frame replaces any unsent
+// frame of the address that starts with the same register and is not longer. the last one
+// with the same length is replaced in place, otherwise the frame is added at the end
+//
+class SerialTwoWireQueue {
+public:
+    static constexpr uint16_t kSize = I2C_OVER_UART_QUEUE_SIZE;
+    static constexpr uint8_t kPriorities = I2C_OVER_UART_QUEUE_PRIORITIES;
+    static constexpr uint8_t kDefaultPriority = I2C_OVER_UART_QUEUE_DEFAULT_PRIORITY;
+    static constexpr uint8_t kAddresses = I2C_OVER_UART_QUEUE_ADDRESSES;
+    static constexpr uint8_t kHeaderSize = 3;
+    static constexpr uint8_t kUnused = 0xff;
+
+    struct Stats {
+        uint32_t _queued;
+        uint32_t _sent;
+        uint32_t _full;                         // queue full, the caller had to wait
+        uint32_t _coalesced;                    // frames replaced before they have been sent
+        uint16_t _maxLatency[kPriorities];      // max. time in the queue in milliseconds
+
+        Stats() : _queued(0), _sent(0), _full(0), _coalesced(0), _maxLatency() {}
+    };
+
+protected:
+    struct Address_t {
+        uint8_t _address;                       // kUnused
+        uint8_t _priority;
+        bool _coalesce;
+        SerialTwoWireTokenBucket _limit;
+    };
+
+public:
+    SerialTwoWireQueue();
+
+    // returns false if there is no free slot
+    bool setPriority(uint8_t address, uint8_t priority);
+    uint8_t getPriority(uint8_t address) const;
+    // limit the transmissions to address to rate bytes per second with bursts up to burst
+    // bytes. rate 0 removes the limit. returns false if there is no free slot
+    bool setRateLimit(uint8_t address, uint16_t rate, uint16_t burst);
+    // writes to the same register of address replace unsent frames. returns false if
+    // there is no free slot
+    bool setCoalescing(uint8_t address, bool enable);
+
+    // add frame with length bytes including the address. returns false if the queue is full
+    bool push(const uint8_t *frame, uint8_t length);
+    // returns true if a frame with length bytes can be added
+    bool fits(uint8_t length) const;
+
+    // returns the next frame that can be sent or nullptr. if address is not kUnused, the oldest
+    // frame of the address is returned ignoring priorities and rate limits. if limits is false,
+    // the rate limits are ignored for all addresses
+    const uint8_t *next(uint8_t &length, uint8_t address = kUnused, bool limits = true);
+
+    // remove frame returned by next() after it has been sent
+    void pop(const uint8_t *frame);
+
+    void clear();
+    bool empty() const;
+    bool contains(uint8_t address) const;
+
+    const Stats &getStats() const;
+    void resetStats();
+
+private:
+    Address_t *_find(uint8_t address);
+    const Address_t *_find(uint8_t address) const;
+    Address_t *_add(uint8_t address);
+    uint16_t _getPosition(const uint8_t *frame) const;
+    void _remove(uint16_t pos);
+    // returns true if frame has replaced a queued frame in place
+    bool _coalesce(const uint8_t *frame, uint8_t length);
+
+    Address_t _addresses[kAddresses];
+    uint8_t _buffer[kSize];
+    uint16_t _length;
+    uint8_t _lastAddress;
+    Stats _stats;
+};
+
+#include "SerialTwoWireQueue.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
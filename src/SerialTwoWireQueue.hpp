@@ -0,0 +1,79 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireQueue.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+inline SerialTwoWireQueue::SerialTwoWireQueue() : _length(0), _lastAddress(0)
+{
+    for(auto &address: _addresses) {
+        address._address = kUnused;
+    }
+}
+
+inline uint8_t SerialTwoWireQueue::getPriority(uint8_t address) const
+{
+    auto ptr = _find(address);
+    return ptr ? ptr->_priority : kDefaultPriority;
+}
+
+inline bool SerialTwoWireQueue::fits(uint8_t length) const
+{
+    return _length + kHeaderSize + length <= kSize;
+}
+
+inline void SerialTwoWireQueue::clear()
+{
+    _length = 0;
+}
+
+inline bool SerialTwoWireQueue::empty() const
+{
+    return _length == 0;
+}
+
+inline const SerialTwoWireQueue::Stats &SerialTwoWireQueue::getStats() const
+{
+    return _stats;
+}
+
+inline void SerialTwoWireQueue::resetStats()
+{
+    _stats = Stats();
+}
+
+inline SerialTwoWireQueue::Address_t *SerialTwoWireQueue::_find(uint8_t address)
+{
+    for(auto &item: _addresses) {
+        if (item._address == address) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+
+inline const SerialTwoWireQueue::Address_t *SerialTwoWireQueue::_find(uint8_t address) const
+{
+    for(const auto &item: _addresses) {
+        if (item._address == address) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+
+inline uint16_t SerialTwoWireQueue::_getPosition(const uint8_t *frame) const
+{
+    return (frame - _buffer) - kHeaderSize;
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,167 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWireReadCache.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+
+bool SerialTwoWireReadCache::setTTL(uint8_t address, uint16_t ttl)
+{
+    auto ptr = _find(address);
+    if (ttl == 0) {
+        if (ptr) {
+            invalidate(address);
+            ptr->_address = kUnused;
+        }
+        return true;
+    }
+    if (!ptr) {
+        ptr = _find(kUnused);
+        if (!ptr) {
+            __LDBG_printf("addr=%02x no free slot", address);
+            return false;
+        }
+        ptr->_address = address;
+        ptr->_registerValid = false;
+        ptr->_registerPending = false;
+    }
+    ptr->_ttl = ttl;
+    return true;
+}
+
+void SerialTwoWireReadCache::invalidate(uint8_t address)
+{
+    for(auto &entry: _entries) {
+        if (entry._address == address) {
+            entry._address = kUnused;
+        }
+    }
+}
+
+void SerialTwoWireReadCache::clear()
+{
+    for(auto &entry: _entries) {
+        entry._address = kUnused;
+    }
+}
+
+bool SerialTwoWireReadCache::transmit(uint8_t address, const uint8_t *data, size_t length)
+{
+    auto ptr = _find(address);
+    if (!ptr) {
+        return false;
+    }
+    if (length == 1) {
+        ptr->_register = *data;
+        ptr->_registerValid = true;
+        ptr->_registerPending = true;
+        return true;
+    }
+    // the transmission replaces the pending register pointer
+    ptr->_registerValid = false;
+    ptr->_registerPending = false;
+    invalidate(address);
+    return false;
+}
+
+bool SerialTwoWireReadCache::getPendingRegister(uint8_t address, uint8_t &reg)
+{
+    auto ptr = _find(address);
+    if (!ptr || !ptr->_registerPending) {
+        return false;
+    }
+    ptr->_registerPending = false;
+    reg = ptr->_register;
+    return true;
+}
+
+bool SerialTwoWireReadCache::getPendingAddress(uint8_t &address) const
+{
+    for(const auto &item: _addresses) {
+        if (item._address != kUnused && item._registerPending) {
+            address = item._address;
+            return true;
+        }
+    }
+    return false;
+}
+
+const uint8_t *SerialTwoWireReadCache::get(uint8_t address, uint8_t length)
+{
+    auto ptr = _find(address);
+    if (!ptr) {
+        return nullptr;
+    }
+    if (ptr->_registerValid && length <= kMaxLength) {
+        auto entry = _findEntry(address, ptr->_register, length);
+        if (entry) {
+            if ((uint32_t)(millis() - entry->_time) < ptr->_ttl) {
+                _stats._hits++;
+                // the register pointer the entry has been read with is not sent. any other
+                // pending byte might be a command and is sent by the master
+                if (ptr->_registerPending && ptr->_register == entry->_register) {
+                    ptr->_registerPending = false;
+                }
+                ptr->_registerValid = false;
+                return entry->_data;
+            }
+            entry->_address = kUnused;
+        }
+    }
+    _stats._misses++;
+    return nullptr;
+}
+
+void SerialTwoWireReadCache::update(uint8_t address, const uint8_t *data, uint8_t length)
+{
+    auto ptr = _find(address);
+    if (!ptr) {
+        return;
+    }
+    if (data && ptr->_registerValid && length <= kMaxLength) {
+        auto entry = _findEntry(address, ptr->_register, length);
+        if (!entry) {
+            // use a free slot or replace the oldest entry
+            uint32_t now = millis();
+            uint32_t maxAge = 0;
+            entry = &_entries[0];
+            for(auto &item: _entries) {
+                if (item._address == kUnused) {
+                    entry = &item;
+                    break;
+                }
+                uint32_t age = now - item._time;
+                if (age >= maxAge) {
+                    maxAge = age;
+                    entry = &item;
+                }
+            }
+        }
+        entry->_address = address;
+        entry->_register = ptr->_register;
+        entry->_length = length;
+        entry->_time = millis();
+        memcpy(entry->_data, data, length);
+    }
+    // the register pointer of the device is unknown after reading
+    ptr->_registerValid = false;
+}
+
+SerialTwoWireReadCache::Entry_t *SerialTwoWireReadCache::_findEntry(uint8_t address, uint8_t reg, uint8_t length)
+{
+    for(auto &entry: _entries) {
+        if (entry._address == address && entry._register == reg && entry._length == length) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+#endif
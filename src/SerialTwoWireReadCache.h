@@ -0,0 +1,105 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+using namespace SerialTwoWireDef;
+
+#if I2C_OVER_UART_ENABLE_READ_CACHE
+
+//
+// Response cache for SerialTwoWireMaster::requestFrom()
+//
+// entries are keyed by address, register pointer and length. the register pointer is the
+// single byte written by the last transmission to the address, any transmission with more
+// than one byte invalidates all entries of the address
+//
+// only addresses with a TTL are cached. the register pointer written to those addresses is
+// not sent until a request cannot be answered from the cache. only one register pointer is
+// pending, the master sends it if the next call is not a request to the same address.
+// reading without writing the register pointer first is passed through and never cached
+//
+class SerialTwoWireReadCache {
+public:
+    static constexpr uint8_t kEntries = I2C_OVER_UART_READ_CACHE_ENTRIES;
+    static constexpr uint8_t kMaxLength = I2C_OVER_UART_READ_CACHE_MAX_LENGTH;
+    static constexpr uint8_t kAddresses = I2C_OVER_UART_READ_CACHE_ADDRESSES;
+    static constexpr uint8_t kUnused = 0xff;
+
+    struct Stats {
+        uint32_t _hits;
+        uint32_t _misses;
+
+        Stats() : _hits(0), _misses(0) {}
+    };
+
+protected:
+    struct __attribute__((packed)) Address_t {
+        uint8_t _address;               // kUnused
+        uint8_t _register;
+        bool _registerValid;
+        bool _registerPending;          // register pointer has not been sent yet
+        uint16_t _ttl;
+    };
+
+    struct __attribute__((packed)) Entry_t {
+        uint8_t _address;               // kUnused
+        uint8_t _register;
+        uint8_t _length;
+        uint32_t _time;
+        uint8_t _data[kMaxLength];
+    };
+
+public:
+    SerialTwoWireReadCache();
+
+    // set TTL in milliseconds for address. 0 removes the address
+    // returns false if there is no free slot
+    bool setTTL(uint8_t address, uint16_t ttl);
+    uint16_t getTTL(uint8_t address) const;
+
+    void invalidate(uint8_t address);
+    void clear();
+
+    const Stats &getStats() const;
+    void resetStats();
+
+    // returns true if the transmission is a register pointer that is not sent yet
+    bool transmit(uint8_t address, const uint8_t *data, size_t length);
+
+    // returns true if a register pointer is pending and must be sent before requesting data
+    bool getPendingRegister(uint8_t address, uint8_t &reg);
+    // returns true and the address if any register pointer is pending
+    bool getPendingAddress(uint8_t &address) const;
+
+    // returns the cached response or nullptr
+    const uint8_t *get(uint8_t address, uint8_t length);
+
+    // store response of requestFrom(). data is nullptr if the request failed
+    void update(uint8_t address, const uint8_t *data, uint8_t length);
+
+private:
+    Address_t *_find(uint8_t address);
+    const Address_t *_find(uint8_t address) const;
+    Entry_t *_findEntry(uint8_t address, uint8_t reg, uint8_t length);
+
+    Address_t _addresses[kAddresses];
+    Entry_t _entries[kEntries];
+    Stats _stats;
+};
+
+#include "SerialTwoWireReadCache.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,60 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireReadCache.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+inline SerialTwoWireReadCache::SerialTwoWireReadCache()
+{
+    for(auto &address: _addresses) {
+        address._address = kUnused;
+    }
+    clear();
+}
+
+inline uint16_t SerialTwoWireReadCache::getTTL(uint8_t address) const
+{
+    auto ptr = _find(address);
+    return ptr ? ptr->_ttl : 0;
+}
+
+inline const SerialTwoWireReadCache::Stats &SerialTwoWireReadCache::getStats() const
+{
+    return _stats;
+}
+
+inline void SerialTwoWireReadCache::resetStats()
+{
+    _stats = Stats();
+}
+
+inline SerialTwoWireReadCache::Address_t *SerialTwoWireReadCache::_find(uint8_t address)
+{
+    for(auto &item: _addresses) {
+        if (item._address == address) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+
+inline const SerialTwoWireReadCache::Address_t *SerialTwoWireReadCache::_find(uint8_t address) const
+{
+    for(const auto &item: _addresses) {
+        if (item._address == address) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,57 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWireRemark.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+
+size_t SerialTwoWireRemark::write(uint8_t data)
+{
+    if (data == '\r') {
+        return 1;
+    }
+    if (data == '\n') {
+        if (_overflow) {
+            _overflow = false;
+            _stats._dropped++;
+        }
+        else if (_length != _lineStart) {
+            _buffer[_length++] = '\n';
+            _lineStart = _length;
+        }
+        return 1;
+    }
+    if (_overflow) {
+        return 1;
+    }
+    // one byte is reserved for the newline
+    if (_length + 2 > kSize) {
+        __LDBG_printf("drop line len=%u", _length - _lineStart);
+        _overflow = true;
+        _length = _lineStart;
+        return 1;
+    }
+    _buffer[_length++] = (data == '+' || data < ' ') ? kReplacementChar : data;
+    return 1;
+}
+
+void SerialTwoWireRemark::setRateLimit(uint16_t rate, uint16_t burst)
+{
+    _limit.setRateLimit(rate, burst);
+}
+
+void SerialTwoWireRemark::_remove(uint16_t length)
+{
+    _length -= length;
+    _lineStart -= length;
+    memmove(_buffer, &_buffer[length], _length);
+}
+
+#endif
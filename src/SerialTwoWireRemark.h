@@ -0,0 +1,81 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+#include "SerialTwoWireTokenBucket.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+using namespace SerialTwoWireDef;
+
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+
+//
+// Side channel for text sharing the serial port with I2C frames
+//
+// text written to this object is stored in a static buffer and sent as "+REM=<text>" by poll()
+// of the owner between frames. each line is written with a single call and never interrupts a
+// frame. newlines terminate a line, lines that do not fit into the buffer are dropped
+//
+// the output is limited to a number of bytes per second with a token bucket. '+' and control
+// characters are replaced, the receiver could take them as start of a frame
+//
+class SerialTwoWireRemark : public Print {
+public:
+    static constexpr uint16_t kSize = I2C_OVER_UART_REMARK_BUFFER_SIZE;
+    static constexpr uint8_t kReplacementChar = '_';
+    // "+REM=" and newline
+    static constexpr uint8_t kCommandLength = 6;
+
+    struct Stats {
+        uint32_t _lines;                        // lines sent
+        uint32_t _dropped;                      // buffer full
+
+        Stats() : _lines(0), _dropped(0) {}
+    };
+
+public:
+    SerialTwoWireRemark();
+
+    virtual size_t write(uint8_t data) override;
+    using Print::write;
+
+    // limit the output to rate bytes per second with bursts up to burst bytes including
+    // the command and newline. rate 0 removes the limit
+    void setRateLimit(uint16_t rate, uint16_t burst);
+
+    // send lines allowed by the rate limit, callback(text, length). the callback must return
+    // false if the line cannot be sent now
+    template<typename _Ta>
+    void poll(_Ta callback);
+
+    void clear();
+    bool empty() const;
+
+    const Stats &getStats() const;
+    void resetStats();
+
+private:
+    void _remove(uint16_t length);
+
+    uint8_t _buffer[kSize];
+    uint16_t _length;                           // complete and partial lines
+    uint16_t _lineStart;                        // start of the partial line
+    bool _overflow;                             // the partial line is dropped
+    SerialTwoWireTokenBucket _limit;
+    Stats _stats;
+};
+
+#include "SerialTwoWireRemark.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,66 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireRemark.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+inline SerialTwoWireRemark::SerialTwoWireRemark() :
+    _length(0),
+    _lineStart(0),
+    _overflow(false),
+    _limit()
+{
+    setRateLimit(I2C_OVER_UART_REMARK_RATE, I2C_OVER_UART_REMARK_BURST);
+}
+
+template<typename _Ta>
+void SerialTwoWireRemark::poll(_Ta callback)
+{
+    while (_lineStart) {
+        auto end = reinterpret_cast<uint8_t *>(memchr(_buffer, '\n', _lineStart));
+        uint16_t length = end - _buffer;
+        // lines longer than the bucket are sent when it is full
+        if (!_limit.isAllowed(length + kCommandLength, millis())) {
+            return;
+        }
+        if (!callback(_buffer, length)) {
+            return;
+        }
+        _limit.consume(length + kCommandLength);
+        _stats._lines++;
+        _remove(length + 1);
+    }
+}
+
+inline void SerialTwoWireRemark::clear()
+{
+    _length = 0;
+    _lineStart = 0;
+    _overflow = false;
+}
+
+inline bool SerialTwoWireRemark::empty() const
+{
+    return _lineStart == 0;
+}
+
+inline const SerialTwoWireRemark::Stats &SerialTwoWireRemark::getStats() const
+{
+    return _stats;
+}
+
+inline void SerialTwoWireRemark::resetStats()
+{
+    _stats = Stats();
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,104 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWireRetransmit.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+
+void SerialTwoWireRetransmit::begin()
+{
+    clear();
+    // the random number generator might not be seeded, an unknown session is detected
+    // by the receiver anyway
+    _session = random(256) ^ micros();
+    _next = 0;
+    _synced = false;
+}
+
+const uint8_t *SerialTwoWireRetransmit::push(const uint8_t *frame, uint8_t length)
+{
+    if (length == 0 || !fits(length)) {
+        return nullptr;
+    }
+    auto ptr = &_buffer[_length];
+    auto time = _getTime();
+    *ptr++ = length + kSequenceLength;
+    *ptr++ = time;
+    *ptr++ = time >> 8;
+    auto result = ptr;
+    *ptr++ = frame[0];
+    *ptr++ = _session;
+    // the receiver adopts the sequence number of the first frame of a session
+    *ptr++ = _next | ((_count == 0 && !_synced) ? kSyncFlag : 0);
+    memcpy(ptr, frame + 1, length - 1);
+    _length += kHeaderSize + kSequenceLength + length;
+    _next = (_next + 1) & kSequenceMask;
+    _count++;
+    _stats._sent++;
+    return result;
+}
+
+bool SerialTwoWireRetransmit::acknowledge(uint8_t session, uint8_t next)
+{
+    if (session != _session) {
+        // acknowledgement of a previous session
+        return false;
+    }
+    if (!(next & kSyncFlag)) {
+        uint8_t count = _count ? ((next - _buffer[kHeaderSize + 2]) & kSequenceMask) : 0;
+        if (_count ? count <= _count : next == _next) {
+            uint16_t pos = 0;
+            for(uint8_t i = 0; i < count; i++) {
+                pos += kHeaderSize + _buffer[pos];
+            }
+            _length -= pos;
+            memmove(_buffer, &_buffer[pos], _length);
+            _count -= count;
+            _stats._acknowledged += count;
+            _synced = true;
+            return false;
+        }
+        __LDBG_printf("invalid ack next=%u count=%u", next, _count);
+    }
+    else if (!_synced) {
+        // the receiver did not get the first frame of the session yet
+        return false;
+    }
+    _stats._resync++;
+    _newSession();
+    return _count != 0;
+}
+
+void SerialTwoWireRetransmit::dropOldest()
+{
+    if (_count == 0) {
+        return;
+    }
+    auto size = kHeaderSize + _buffer[0];
+    _length -= size;
+    memmove(_buffer, &_buffer[size], _length);
+    _count--;
+    _stats._dropped++;
+    // the receiver cannot skip the missing sequence number
+    _newSession();
+}
+
+void SerialTwoWireRetransmit::_newSession()
+{
+    _session++;
+    _synced = false;
+    for(uint16_t pos = 0; pos < _length; pos += kHeaderSize + _buffer[pos]) {
+        auto frame = &_buffer[pos + kHeaderSize];
+        frame[1] = _session;
+        frame[2] = (frame[2] & kSequenceMask) | (pos == 0 ? kSyncFlag : 0);
+    }
+}
+
+#endif
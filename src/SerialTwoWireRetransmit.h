@@ -0,0 +1,117 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+using namespace SerialTwoWireDef;
+
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+
+//
+// Retransmit buffer for sequenced transmissions
+//
+// "+I2CL=<address><session><sequence><data>" is acknowledged with "+I2CW=<address><session><next sequence>"
+//
+// the sender keeps each frame until the receiver has acknowledged it. acknowledgements are
+// cumulative and if the oldest frame has not been acknowledged after the timeout, all frames
+// are sent again in their original order. the receiver delivers frames in order only and
+// drops duplicates and frames that follow a lost one
+//
+// the session is a random number that changes if the sender starts over. the oldest frame of
+// a new session has kSyncFlag set and the receiver adopts its sequence number. a receiver that
+// does not know the session requests a new one by sending kSyncFlag as next sequence
+//
+// frames are stored as length, time and the transmission including the address, session and
+// sequence number
+//
+class SerialTwoWireRetransmit {
+public:
+    static constexpr uint16_t kSize = I2C_OVER_UART_RETRANSMIT_BUFFER_SIZE;
+    static constexpr uint16_t kTimeout = I2C_OVER_UART_RETRANSMIT_TIMEOUT;
+    static constexpr uint8_t kHeaderSize = 3;
+    // session and sequence number
+    static constexpr uint8_t kSequenceLength = 2;
+    static constexpr uint8_t kSequenceMask = 0x7f;
+    static constexpr uint8_t kSyncFlag = 0x80;
+    // max. number of frames that have not been acknowledged, half of the sequence numbers
+    static constexpr uint8_t kWindow = 64;
+
+    static_assert(kSize >= kHeaderSize + kSequenceLength + 2 && kSize <= 0x7fff, "invalid I2C_OVER_UART_RETRANSMIT_BUFFER_SIZE");
+
+    struct Stats {
+        uint32_t _sent;
+        uint32_t _acknowledged;
+        uint32_t _retransmitted;                // frames sent again
+        uint32_t _dropped;                      // removed without acknowledgement
+        uint32_t _resync;                       // sessions requested by the receiver
+
+        Stats() : _sent(0), _acknowledged(0), _retransmitted(0), _dropped(0), _resync(0) {}
+    };
+
+public:
+    SerialTwoWireRetransmit();
+
+    // drop all frames and start a new session
+    void begin();
+
+    // returns true if a frame with length bytes including the address can be stored
+    bool fits(uint8_t length) const;
+    // returns true if the frame fits into the empty buffer
+    static constexpr bool isValidLength(uint8_t length) {
+        return kHeaderSize + kSequenceLength + length <= kSize;
+    }
+
+    // store frame with length bytes including the address and insert the session and
+    // sequence number after the address. returns the stored frame with length + kSequenceLength
+    // bytes or nullptr if it does not fit
+    const uint8_t *push(const uint8_t *frame, uint8_t length);
+
+    // remove frames acknowledged by next. if the receiver does not know the session or next
+    // is invalid, a new session is started and true is returned. the frames should be sent
+    // again immediately
+    bool acknowledge(uint8_t session, uint8_t next);
+
+    // the oldest frame is removed and a new session is started
+    void dropOldest();
+
+    // returns true if the oldest frame has not been acknowledged within the timeout
+    bool isExpired() const;
+
+    // send all frames again, callback(frame, length)
+    template<typename _Ta>
+    void retransmit(_Ta callback);
+
+    void clear();
+    bool empty() const;
+
+    const Stats &getStats() const;
+    void resetStats();
+
+private:
+    void _newSession();
+    static uint16_t _getTime();
+
+    uint8_t _buffer[kSize];
+    uint16_t _length;
+    uint8_t _count;                             // number of frames
+    uint8_t _session;
+    uint8_t _next;                              // sequence number of the next frame
+    bool _synced;                               // the receiver acknowledged the session
+    Stats _stats;
+};
+
+#include "SerialTwoWireRetransmit.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,68 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireRetransmit.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+inline SerialTwoWireRetransmit::SerialTwoWireRetransmit() : _length(0), _count(0), _session(0), _next(0), _synced(false)
+{
+}
+
+inline bool SerialTwoWireRetransmit::fits(uint8_t length) const
+{
+    return _count < kWindow && _length + kHeaderSize + kSequenceLength + length <= kSize;
+}
+
+inline bool SerialTwoWireRetransmit::isExpired() const
+{
+    return _count && (uint16_t)(_getTime() - (_buffer[1] | (_buffer[2] << 8))) >= kTimeout;
+}
+
+template<typename _Ta>
+void SerialTwoWireRetransmit::retransmit(_Ta callback)
+{
+    auto time = _getTime();
+    for(uint16_t pos = 0; pos < _length; pos += kHeaderSize + _buffer[pos]) {
+        _buffer[pos + 1] = time;
+        _buffer[pos + 2] = time >> 8;
+        _stats._retransmitted++;
+        callback(&_buffer[pos + kHeaderSize], _buffer[pos]);
+    }
+}
+
+inline void SerialTwoWireRetransmit::clear()
+{
+    _length = 0;
+    _count = 0;
+}
+
+inline bool SerialTwoWireRetransmit::empty() const
+{
+    return _count == 0;
+}
+
+inline const SerialTwoWireRetransmit::Stats &SerialTwoWireRetransmit::getStats() const
+{
+    return _stats;
+}
+
+inline void SerialTwoWireRetransmit::resetStats()
+{
+    _stats = Stats();
+}
+
+inline uint16_t SerialTwoWireRetransmit::_getTime()
+{
+    return millis();
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,28 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWireRing.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_RX_RING
+
+SerialTwoWireRing::SerialTwoWireRing() :
+    _head(0),
+    _tail(0),
+    _stats(),
+    _buffer{}
+{
+}
+
+void SerialTwoWireRing::resetStats()
+{
+    _stats = Stats();
+}
+
+#endif
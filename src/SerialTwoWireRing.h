@@ -0,0 +1,85 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+using namespace SerialTwoWireDef;
+
+#if I2C_OVER_UART_ENABLE_RX_RING
+
+//
+// Lock-free receive ring between an interrupt and loop()
+//
+// a single producer, the UART RX interrupt or a task, stores bytes with push() and a single
+// consumer removes them with drain(). the producer writes _head only and the consumer _tail
+// only, no interrupts are disabled. one byte is kept free to tell a full ring from an empty
+// one, the indices fit into a single load or store on 8 bit MCUs
+//
+// bytes that do not fit are dropped and counted. the stats are written by the producer and
+// might be read while they are updated
+//
+class SerialTwoWireRing {
+public:
+    static constexpr uint16_t kSize = I2C_OVER_UART_RX_RING_SIZE;
+    static constexpr uint16_t kMask = kSize - 1;
+
+#if __AVR__
+    using index_t = uint8_t;
+    static_assert(kSize <= 256, "I2C_OVER_UART_RX_RING_SIZE exceeds 256");
+#else
+    using index_t = uint16_t;
+#endif
+    static_assert(kSize >= 2 && (kSize & kMask) == 0, "I2C_OVER_UART_RX_RING_SIZE must be a power of 2");
+
+    struct Stats {
+        uint32_t _received;                     // bytes stored
+        uint32_t _overflows;                    // bytes dropped, ring full
+        uint16_t _maxLevel;                     // max. number of bytes waiting
+
+        Stats() : _received(0), _overflows(0), _maxLevel(0) {}
+    };
+
+public:
+    SerialTwoWireRing();
+
+    // producer side, safe to call from an ISR. returns false if the byte has been dropped
+    bool push(uint8_t data);
+    size_t push(const uint8_t *data, size_t length);
+
+    // consumer side. calls callback(data) for each byte that has been stored before the call
+    // and returns the number of bytes. each byte is removed before the callback is invoked,
+    // the callback can call drain() again
+    template<typename _Ta>
+    size_t drain(_Ta callback);
+
+    // number of bytes waiting
+    size_t available() const;
+    // discard all bytes, consumer side
+    void clear();
+
+    const Stats &getStats() const;
+    // must not be called while the producer is running
+    void resetStats();
+
+private:
+    volatile index_t _head;                     // next byte to write, producer
+    volatile index_t _tail;                     // next byte to read, consumer
+    Stats _stats;
+    uint8_t _buffer[kSize];
+};
+
+#include "SerialTwoWireRing.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,82 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireRing.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+inline bool SerialTwoWireRing::push(uint8_t data)
+{
+    index_t head = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+    index_t next = (head + 1) & kMask;
+    index_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+    if (next == tail) {
+        _stats._overflows++;
+        return false;
+    }
+    _buffer[head] = data;
+    // publish the byte after it has been stored
+    __atomic_store_n(&_head, next, __ATOMIC_RELEASE);
+    _stats._received++;
+    uint16_t level = (next - tail) & kMask;
+    if (level > _stats._maxLevel) {
+        _stats._maxLevel = level;
+    }
+    return true;
+}
+
+inline size_t SerialTwoWireRing::push(const uint8_t *data, size_t length)
+{
+    size_t count = 0;
+    while (count < length && push(data[count])) {
+        count++;
+    }
+    if (count < length) {
+        // push() has counted the first byte that did not fit
+        _stats._overflows += length - count - 1;
+    }
+    return count;
+}
+
+template<typename _Ta>
+size_t SerialTwoWireRing::drain(_Ta callback)
+{
+    size_t count = available();
+    for(size_t i = 0; i < count; i++) {
+        // the callback might call drain() again
+        index_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+        if (tail == __atomic_load_n(&_head, __ATOMIC_ACQUIRE)) {
+            return i;
+        }
+        uint8_t data = _buffer[tail];
+        // release the space before the callback
+        __atomic_store_n(&_tail, (tail + 1) & kMask, __ATOMIC_RELEASE);
+        callback(data);
+    }
+    return count;
+}
+
+inline size_t SerialTwoWireRing::available() const
+{
+    return (__atomic_load_n(&_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&_tail, __ATOMIC_RELAXED)) & kMask;
+}
+
+inline void SerialTwoWireRing::clear()
+{
+    __atomic_store_n(&_tail, __atomic_load_n(&_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+}
+
+inline const SerialTwoWireRing::Stats &SerialTwoWireRing::getStats() const
+{
+    return _stats;
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
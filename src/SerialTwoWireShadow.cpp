@@ -0,0 +1,158 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWire.h"
+#include "SerialTwoWireShadow.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_SHADOW
+
+bool SerialTwoWireShadow::add(uint8_t address, uint8_t reg, uint8_t *buffer, uint16_t length)
+{
+    if (!buffer || length == 0 || reg + length > 256) {
+        return false;
+    }
+    remove(address, reg);
+    for(auto &region: _regions) {
+        if (!region._buffer) {
+            region._buffer = buffer;
+            region._length = length;
+            region._address = address;
+            region._register = reg;
+            region._validStart = 0;
+            region._validEnd = 0;
+            return true;
+        }
+    }
+    __LDBG_printf("addr=%02x reg=%02x no free slot", address, reg);
+    return false;
+}
+
+void SerialTwoWireShadow::remove(uint8_t address, uint8_t reg)
+{
+    for(auto &region: _regions) {
+        if (region._buffer && region._address == address && region._register == reg) {
+            region._buffer = nullptr;
+        }
+    }
+}
+
+uint8_t SerialTwoWireShadow::write(uint8_t address, uint8_t reg, const uint8_t *data, uint16_t length)
+{
+    _stats._writes++;
+    _stats._bytes += length;
+    auto region = _find(address, reg, length);
+    if (!region) {
+        // the device has been changed outside of the shadow memory
+        _invalidate(address, reg, length);
+        return _transmit(address, reg, data, length);
+    }
+    uint16_t offset = reg - region->_register;
+    auto shadow = &region->_buffer[offset];
+    if (offset < region->_validStart || offset + length > region->_validEnd) {
+        // the content of the device is not known for all bytes
+        memcpy(shadow, data, length);
+        auto result = _transmit(address, reg, data, length);
+        if (result == 0) {
+            _setValid(*region, offset, length);
+        }
+        else {
+            region->_validStart = region->_validEnd = 0;
+        }
+        return result;
+    }
+    uint8_t result = 0;
+    uint16_t pos = 0;
+    for(;;) {
+        // skip unchanged bytes
+        while (pos < length && shadow[pos] == data[pos]) {
+            pos++;
+        }
+        if (pos >= length) {
+            break;
+        }
+        // the run ends if more than kMergeGap unchanged bytes follow
+        uint16_t end = pos + 1;
+        for(uint16_t i = end; i < length; i++) {
+            if (shadow[i] != data[i]) {
+                end = i + 1;
+            }
+            else if (i - end >= kMergeGap) {
+                break;
+            }
+        }
+        memcpy(&shadow[pos], &data[pos], end - pos);
+        auto code = _transmit(address, reg + pos, &data[pos], end - pos);
+        if (code) {
+            region->_validStart = region->_validEnd = 0;
+            result = code;
+        }
+        pos = end;
+    }
+    return result;
+}
+
+SerialTwoWireShadow::Region_t *SerialTwoWireShadow::_find(uint8_t address, uint8_t reg, uint16_t length)
+{
+    for(auto &region: _regions) {
+        if (region._buffer && region._address == address && reg >= region._register && reg + length <= region._register + region._length) {
+            return &region;
+        }
+    }
+    return nullptr;
+}
+
+void SerialTwoWireShadow::_invalidate(uint8_t address, uint8_t reg, uint16_t length)
+{
+    for(auto &region: _regions) {
+        if (region._buffer && region._address == address && reg < region._register + region._length && reg + length > region._register) {
+            region._validStart = region._validEnd = 0;
+        }
+    }
+}
+
+void SerialTwoWireShadow::_setValid(Region_t &region, uint16_t offset, uint16_t length)
+{
+    uint16_t end = offset + length;
+    if (region._validStart == region._validEnd || end < region._validStart || offset > region._validEnd) {
+        // empty or not adjacent, only one range is tracked
+        region._validStart = offset;
+        region._validEnd = end;
+        return;
+    }
+    if (offset < region._validStart) {
+        region._validStart = offset;
+    }
+    if (end > region._validEnd) {
+        region._validEnd = end;
+    }
+}
+
+uint8_t SerialTwoWireShadow::_transmit(uint8_t address, uint8_t reg, const uint8_t *data, uint16_t length)
+{
+    do {
+        uint8_t len = length < kMaxLength - 1 ? length : kMaxLength - 1;
+        _master.beginTransmission(address);
+        _master.write(reg);
+        _master.write(data, len);
+        auto code = _master.endTransmission();
+        _stats._transmissions++;
+        _stats._sent += len;
+        if (code) {
+            __LDBG_printf("addr=%02x reg=%02x len=%u code=%u", address, reg, len, code);
+            return code;
+        }
+        reg += len;
+        data += len;
+        length -= len;
+    } while (length);
+    return 0;
+}
+
+#endif
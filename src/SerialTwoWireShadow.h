@@ -0,0 +1,87 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireMaster.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_SHADOW
+
+//
+// Shadow memory for SerialTwoWireMaster
+//
+// keeps a copy of a register range of a device with auto incrementing register pointer, for
+// example display RAM or LED drivers. writes to the range only transmit the bytes that have
+// changed. runs separated by up to I2C_OVER_UART_SHADOW_MERGE_GAP unchanged bytes are merged
+// into one transmission
+//
+// the buffer is provided by the caller. the part of the buffer that matches the device is
+// tracked as one range, which is empty after adding the range or a failed transmission. writes
+// outside of it send all bytes and extend it
+//
+class SerialTwoWireShadow {
+public:
+    static constexpr uint8_t kRegions = I2C_OVER_UART_SHADOW_REGIONS;
+    static constexpr uint8_t kMergeGap = I2C_OVER_UART_SHADOW_MERGE_GAP;
+    static constexpr uint8_t kMaxLength = I2C_OVER_UART_SHADOW_MAX_LENGTH;
+
+    struct Stats {
+        uint32_t _writes;
+        uint32_t _bytes;                    // bytes passed to write()
+        uint32_t _sent;                     // bytes transmitted without the register
+        uint32_t _transmissions;
+
+        Stats() : _writes(0), _bytes(0), _sent(0), _transmissions(0) {}
+    };
+
+protected:
+    struct Region_t {
+        uint8_t *_buffer;                   // nullptr = unused
+        uint16_t _length;
+        uint8_t _address;
+        uint8_t _register;
+        uint16_t _validStart;               // offset of the bytes matching the device
+        uint16_t _validEnd;                 // _validStart = _validEnd: unknown
+    };
+
+public:
+    SerialTwoWireShadow(SerialTwoWireMaster &master);
+
+    // shadow length bytes starting at register reg of address. buffer must be valid until
+    // the range is removed. returns false if there is no free slot or the range is invalid
+    bool add(uint8_t address, uint8_t reg, uint8_t *buffer, uint16_t length);
+    void remove(uint8_t address, uint8_t reg);
+    // the next write to the ranges of address sends all bytes
+    void invalidate(uint8_t address);
+
+    // write length bytes starting at register reg. writes that are not inside a range are sent
+    // unchanged. returns 0 or the error of endTransmission()
+    uint8_t write(uint8_t address, uint8_t reg, const uint8_t *data, uint16_t length);
+
+    const Stats &getStats() const;
+    void resetStats();
+
+private:
+    Region_t *_find(uint8_t address, uint8_t reg, uint16_t length);
+    void _invalidate(uint8_t address, uint8_t reg, uint16_t length);
+    void _setValid(Region_t &region, uint16_t offset, uint16_t length);
+    uint8_t _transmit(uint8_t address, uint8_t reg, const uint8_t *data, uint16_t length);
+
+    SerialTwoWireMaster &_master;
+    Region_t _regions[kRegions];
+    Stats _stats;
+};
+
+#include "SerialTwoWireShadow.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
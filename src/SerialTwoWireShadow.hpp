@@ -0,0 +1,38 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireShadow.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+inline SerialTwoWireShadow::SerialTwoWireShadow(SerialTwoWireMaster &master) : _master(master)
+{
+    for(auto &region: _regions) {
+        region._buffer = nullptr;
+    }
+}
+
+inline void SerialTwoWireShadow::invalidate(uint8_t address)
+{
+    _invalidate(address, 0, 256);
+}
+
+inline const SerialTwoWireShadow::Stats &SerialTwoWireShadow::getStats() const
+{
+    return _stats;
+}
+
+inline void SerialTwoWireShadow::resetStats()
+{
+    _stats = Stats();
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
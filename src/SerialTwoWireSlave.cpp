@@ -18,7 +18,16 @@ SerialTwoWireSlave::SerialTwoWireSlave(Stream &serial, onReadSerialCallback call
     _onRequest(nullptr),
     _onReadSerial(callback),
     _serial(&serial)
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+    , _deferredAddress(kNotInitializedAddress)
+    , _deferredRetryAfter(0)
+#endif
 {
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+    for(auto &item: _subscriptions) {
+        item._length = 0;
+    }
+#endif
 }
 
 void SerialTwoWireSlave::begin(uint8_t address)
@@ -27,6 +36,9 @@ void SerialTwoWireSlave::begin(uint8_t address)
     __LDBG_assertf(data()._address == kNotInitializedAddress, "begin called again without end");
     _end();
     data()._address = address;
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    _retransmit.begin();
+#endif
     _in.reserve(SerialTwoWireStream::kAllocMinSize);
     _out.reserve(SerialTwoWireStream::kAllocMinSize);
 #if DEBUG_SERIALTWOWIRE
@@ -40,6 +52,26 @@ void SerialTwoWireSlave::_end()
         data() = Data_t();
         _in.release();
         _out.release();
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+        _deferredAddress = kNotInitializedAddress;
+#endif
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+        for(auto &item: _subscriptions) {
+            item._length = 0;
+        }
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+        _flowCredits = kFlowWindow;
+        _flowConsumed = 0;
+        _flowLineLength = 0;
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+        _peer = Capabilities();
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+        _retransmit.clear();
+        _sequenceSynced = false;
+#endif
     }
 }
 
@@ -82,39 +114,90 @@ void SerialTwoWireSlave::_newLine()
 {
     // add any data left in the buffer
     _addBuffer(_parseData(true));
+#if I2C_OVER_UART_ENABLE_FEC
+    if (_fecCorrect()) {
+        for(uint8_t i = 0; i < _fecLength && flags()._getCommand() > CommandType::DISCARD; i++) {
+            _addBuffer(_fecBuffer[i]);
+        }
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+    if (flags()._compressed && !_decoder.isComplete()) {
+        __LDBG_printf("discard incomplete compressed data ilen=%u", _in.length());
+        _discard();
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    if (flags()._sequenced && flags()._getCommand() > CommandType::DISCARD && flags()._inState) {
+        _receiveSequenced(0);
+    }
+#endif
 
     __LDBG_printf("cmd=%s len=%u ilen=%u discard=%u outs=%u ins=%u", flags()._getCommandAsString().c_str(), data()._length, _in.length(), (flags()._getCommand() <= CommandType::DISCARD || _in.length() == 0), flags()._outState, flags()._inState);
     if (flags()._getCommand() > CommandType::DISCARD && flags()._inState) {
+        flags()._processing = true;
         _processData();
+        flags()._processing = false;
     }
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    _flowNewLine();
+#endif
     _cleanup();
 }
 
 void SerialTwoWireSlave::_cleanup()
 {
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+    _endUnknownLine();
+#endif
     flags()._setCommand(CommandType::NONE);
     data()._length = 0;
     if (flags()._inState) {
         _in.clear();
         flags()._inState = false;
     }
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+    flags()._compressed = false;
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    flags()._sequenced = false;
+#endif
+#if I2C_OVER_UART_ENABLE_FEC
+    _fecLength = 0;
+#endif
     //if (flags()._outIsFilling()) {
     //    flags()._setOutState(OutStateType::NONE);
     //}
 #if I2C_OVER_UART_ADD_CRC16
     flags()._crcMarker = false;
-    flags()._crc = ~0;
+    flags()._crc = Checksum::kInit;
 #endif
 }
 
+void SerialTwoWireSlave::_wait(uint32_t start, uint32_t timeout)
+{
+#if I2C_OVER_UART_ENABLE_WAITER
+    if (_waiter) {
+        uint32_t elapsed = millis() - start;
+        uint32_t remaining = elapsed < timeout ? timeout - elapsed : 0;
+        _waiter->wait(remaining < I2C_OVER_UART_WAITER_MAX_WAIT ? remaining : I2C_OVER_UART_WAITER_MAX_WAIT);
+    }
+    else
+#endif
+    {
+        optimistic_yield(1000);
+    }
+    _invokeOnReadSerial();
+}
+
 void SerialTwoWireSlave::_sendNack(uint8_t address)
 {
     _serial->flush();
-    sendCommandStr(*_serial, CommandStringType::SLAVE_RESPONSE);
+    _printCommand(CommandStringType::SLAVE_RESPONSE);
 #if I2C_OVER_UART_ADD_CRC16
-    // TODO
-    _printHex(address);
-    _println();
+    checksum_t crc = Checksum::kInit;
+    _printHexUpdateCrc(address, crc);
+    _printHexCrc(crc);
 #else
     _printHex(address);
     _println();
@@ -124,15 +207,27 @@ void SerialTwoWireSlave::_sendNack(uint8_t address)
 
 void SerialTwoWireSlave::feed(uint8_t byte)
 {
+#if I2C_OVER_UART_ENABLE_RESYNC
+    _resync(byte);
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    _flowLineLength++;
+#endif
     if (byte == '\n') { // check first
         _newLine();
     }
     else if (flags()._getCommand() == CommandType::DISCARD || byte == '\r') {
         // skip rest of the line cause of invalid data
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+        _forwardUnknownLine(byte);
+#endif
     }
     else if (flags()._getCommand() == CommandType::NONE) {
         //static_assert(kCommandMaxLength < sizeof(_buffer), "invalid size");
         if ((data()._length == 0 && byte != '+') || data()._length >= kCommandMaxLength) {
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+            _beginUnknownLine(byte);
+#endif
             data()._length = 0;
             _discard();
         }
@@ -152,7 +247,52 @@ void SerialTwoWireSlave::feed(uint8_t byte)
                     data()._length = 0;
                     _newTransmission();
                     break;
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+                case CommandStringType::COMPRESSED_TRANSMIT:
+                    flags()._setCommand(CommandType::MASTER_TRANSMIT);
+                    data()._length = 0;
+                    _newTransmission();
+                    _beginCompressed();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+                case CommandStringType::SEQUENCED_TRANSMIT:
+                    flags()._setCommand(CommandType::MASTER_TRANSMIT);
+                    flags()._sequenced = true;
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+                case CommandStringType::ACKNOWLEDGE:
+                    flags()._setCommand(CommandType::ACKNOWLEDGE);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+                case CommandStringType::SUBSCRIBE:
+                    flags()._setCommand(CommandType::SUBSCRIBE);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+                case CommandStringType::FLOW_CONTROL:
+                    flags()._setCommand(CommandType::FLOW_CONTROL);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+                case CommandStringType::NEGOTIATE:
+                    flags()._setCommand(CommandType::NEGOTIATE);
+                    data()._length = 0;
+                    _newTransmission();
+                    break;
+#endif
                 default:
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+                    _findCommandHandler();
+#endif
                     break;
             }
         }
@@ -169,9 +309,16 @@ void SerialTwoWireSlave::feed(uint8_t byte)
         _addBuffer(_parseData());
     }
     else if (byte != ',' && !isspace(byte)) {
+#if I2C_OVER_UART_ENABLE_FEC
+        // probably a corrupted digit, replace it and let the FEC correct the byte
+        __LDBG_printf("replace data=%u", byte);
+        _buffer[data()._length++] = '0';
+        _addBuffer(_parseData());
+#else
         // invalid data, discard
         __LDBG_printf("discard data=%u", byte);
         _discard();
+#endif
     }
 }
 
@@ -181,38 +328,43 @@ int SerialTwoWireSlave::_parseData(bool lastByte)
         return kNoDataAvailable;
     }
 #if I2C_OVER_UART_ADD_CRC16
-    else if (data()._length > 4) {
-        __LDBG_printf("discard len=%u", data()._length);
-        _discard();
-        return kNoDataAvailable;
-    }
-    else if (lastByte || data()._length == 4) {
-        if (!flags()._crcMarker || flags()._crc == ~0 || (data()._length != 0 && data()._length != 4)) { // no marker, no data, invalid length
-            __LDBG_printf("discard crc_marker=%u _crc=%04x", flags()._crcMarker, flags()._crc);
+    else if (flags()._crcMarker) {
+        if (!lastByte && data()._length < kChecksumLength) {
+            return kNoDataAvailable;
         }
-        else {
-            _buffer[4] = 0;
-            auto crc = (uint16_t)strtoul(reinterpret_cast<const char *>(_buffer), nullptr, 16);
+        if (data()._length == kChecksumLength) {
+            checksum_t crc = 0;
+            for(uint8_t i = 0; i < kChecksumLength; i++) {
+                crc = (crc << 4) | _parseNibble(_buffer[i]);
+            }
+#if I2C_OVER_UART_ENABLE_FEC
+            // verified after the correction
+            _fecChecksum = crc;
+            return kNoDataAvailable;
+#else
             if (crc == flags()._crc) {
                 return kNoDataAvailable;
             }
-            __LDBG_printf("discard crc=%04x flags()._crc=%04x", flags()._crc, crc);
+#endif
+            __LDBG_printf("discard crc=%04x flags()._crc=%04x", crc, flags()._crc);
         }
         __LDBG_printf("discard len=%u", data()._length);
         _discard();
         return kNoDataAvailable;
     }
-    else if (flags()._crcMarker && data()._length < 4) { // && lastByte == false
+    else if (lastByte) {
+        // no marker
+        __LDBG_printf("discard crc_marker=%u len=%u", flags()._crcMarker, data()._length);
+        _discard();
         return kNoDataAvailable;
     }
-#else
+#endif
     else if (data()._length > 2) {
         __LDBG_assertf(data()._length <= 2, "cmd=%s len=%u last_byte=%u buf=%-*.*s", flags()._getCommandAsString().c_str(), data()._length, lastByte, (sizeof(_buffer) - 1), (sizeof(_buffer) - 1), _buffer);
         __LDBG_printf("discard len=%u", data()._length);
         _discard();
         return kNoDataAvailable;
     }
-#endif
     else if (lastByte && data()._length == 1) {
         __LDBG_printf("discard len=%u", data()._length);
         _discard();
@@ -222,13 +374,23 @@ int SerialTwoWireSlave::_parseData(bool lastByte)
         return kNoDataAvailable;
     }
     __LDBG_assertf(data()._length <= 2, "cmd=%s len=%u last_byte=%u buf=%-*.*s", flags()._getCommandAsString().c_str(), data()._length, lastByte, (sizeof(_buffer) - 1), (sizeof(_buffer) - 1), _buffer);
-    _buffer[2] = 0;
-#if I2C_OVER_UART_ADD_CRC16
-    auto data = (uint8_t)strtoul(reinterpret_cast<const char *>(_buffer), nullptr, 16);
-    flags()._crc = _crc16_update(flags()._crc, data);
-    return data;
+    auto byte = _parseHex(_buffer);
+#if I2C_OVER_UART_ENABLE_FEC
+    // the frame is processed after the correction
+    data()._length = 0;
+    if (_fecLength >= kFecBufferSize) {
+        __LDBG_printf("discard fec len=%u max=%u", _fecLength, kFecBufferSize);
+        _discard();
+    }
+    else {
+        _fecBuffer[_fecLength++] = byte;
+    }
+    return kNoDataAvailable;
 #else
-    return (uint8_t)strtoul(reinterpret_cast<const char *>(_buffer), nullptr, 16);
+#if I2C_OVER_UART_ADD_CRC16
+    flags()._crc = Checksum::update(flags()._crc, byte);
+#endif
+    return byte;
 #endif
 }
 
@@ -238,6 +400,12 @@ void SerialTwoWireSlave::_addBuffer(int byte)
         return;
     }
     if (flags()._inState) {
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+        if (flags()._compressed) {
+            _addCompressed(byte, kTransmissionMaxLength);
+        }
+        else
+#endif
         if (_in.length() >= kTransmissionMaxLength) {
             __LDBG_printf("data=%u ilen=%u max=%u", byte, _in.length(), kTransmissionMaxLength);
             _discard();
@@ -249,6 +417,30 @@ void SerialTwoWireSlave::_addBuffer(int byte)
     }
     else {
         __LDBG_assertf(_in.length() == 0, "len=%u data=%d", data()._length, byte);
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+        if (flags()._getCommand() == CommandType::NEGOTIATE) {
+            // accepted from any address
+            _in.write(byte);
+            flags()._inState = true;
+        }
+        else
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+        if (flags()._getCommand() == CommandType::FLOW_CONTROL) {
+            // credits are accepted from any address
+            _in.write(byte);
+            flags()._inState = true;
+        }
+        else
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+        if (flags()._getCommand() == CommandType::ACKNOWLEDGE) {
+            // accepted from any address
+            _in.write(byte);
+            flags()._inState = true;
+        }
+        else
+#endif
         if (byte == data()._address) {
             // mark as being in use
             flags()._inState = true;
@@ -264,6 +456,15 @@ void SerialTwoWireSlave::_addBuffer(int byte)
 
 void SerialTwoWireSlave::_preProcess()
 {
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    _commitBaudRate();
+#endif
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+    if (flags()._getCommand() == CommandType::COMMAND) {
+        // commands without data are valid
+        return;
+    }
+#endif
     if (flags()._inState && _in.length() == 0) {
         // no data, discard
         __LDBG_printf("iavail=%u ilen=%u", _in.available(), _in.length());
@@ -271,26 +472,265 @@ void SerialTwoWireSlave::_preProcess()
     }
 }
 
+void SerialTwoWireSlave::_processRequest(uint8_t address)
+{
+    // request has address and length only
+    __LDBG_printf("requestFrom addr=%02x len=%u", address, _in.charAt(0));
+    _in.clear();
+    if (flags()._getOutState() != OutStateType::NONE) {
+        // cannot accept request while a transmission is being prepared
+        _sendNack(address);
+        return;
+    }
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+    if (_deferredAddress == address) {
+        // the response is still pending
+        _sendBusy(address);
+        return;
+    }
+#endif
+    beginTransmission(address);
+    // collect data in output buffer
+    _invokeOnRequest();
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+    if (_deferredAddress == address) {
+        // deferResponse() has been called inside the callback
+        _out.clear();
+        flags()._setOutState(OutStateType::NONE);
+        _sendBusy(address);
+        return;
+    }
+#endif
+    _endTransmission(CommandStringType::SLAVE_RESPONSE, true);
+}
+
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+
+void SerialTwoWireSlave::_sendBusy(uint8_t address)
+{
+    if (_deferredRetryAfter == 0) {
+        return;
+    }
+    beginTransmission(address);
+    _out.write(_deferredRetryAfter >> 8);
+    _out.write((uint8_t)_deferredRetryAfter);
+    _endTransmission(CommandStringType::SLAVE_BUSY, true);
+}
+
+uint8_t SerialTwoWireSlave::respond(uint8_t address, const uint8_t *data, size_t length)
+{
+    if (_deferredAddress != address) {
+        return static_cast<uint8_t>(EndTransmissionCode::END_WITHOUT_BEGIN);
+    }
+    if (length >= kTransmissionMaxLength) {
+        return static_cast<uint8_t>(EndTransmissionCode::DATA_TOO_LONG);
+    }
+    if (flags()._getOutState() != OutStateType::NONE) {
+        return static_cast<uint8_t>(EndTransmissionCode::OTHER);
+    }
+    _deferredAddress = kNotInitializedAddress;
+    beginTransmission(address);
+    _out.write(data, length);
+    return _endTransmission(CommandStringType::SLAVE_RESPONSE, true);
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+
+bool SerialTwoWireSlave::_waitForCredits(uint16_t length)
+{
+    bool result = true;
+    // frames that exceed the window are sent when the receive buffer is empty
+    auto required = length > kFlowWindow ? kFlowWindow : length;
+    // cannot wait while processing received data
+    if (_flowCredits < required && !flags()._processing) {
+        __LDBG_printf("wait credits=%u len=%u", _flowCredits, length);
+        _flowStats._waits++;
+        auto start = millis();
+        while (_flowCredits < required) {
+            if ((uint32_t)(millis() - start) > I2C_OVER_UART_FLOW_TIMEOUT) {
+                // update lost, assume that the receive buffer is empty
+                _flowStats._timeouts++;
+                _flowCredits = kFlowWindow;
+                result = false;
+                break;
+            }
+            _wait(start, I2C_OVER_UART_FLOW_TIMEOUT);
+        }
+    }
+    _flowCredits = _flowCredits > length ? _flowCredits - length : 0;
+    return result;
+}
+
+void SerialTwoWireSlave::_sendCredits()
+{
+    if (flags()._getOutState() != OutStateType::NONE) {
+        // try again later
+        return;
+    }
+    auto credits = _flowConsumed;
+    _flowConsumed = 0;
+    _flowStats._updatesSent++;
+    beginTransmission(data()._getAddress());
+    _out.write(credits >> 8);
+    _out.write((uint8_t)credits);
+    _endTransmission(CommandStringType::FLOW_CONTROL, true);
+}
+
+void SerialTwoWireSlave::_processCredits()
+{
+    // sender address and number of bytes
+    if (flags()._inState && _in.length() == 3) {
+        uint32_t credits = _flowCredits + ((_in[1] << 8) | _in[2]);
+        _flowCredits = credits > kFlowWindow ? kFlowWindow : credits;
+        _flowStats._updatesReceived++;
+    }
+}
+
+void SerialTwoWireSlave::_flowNewLine()
+{
+    // credit updates are not counted, otherwise they would be answered with updates
+    if (flags()._getCommand() != CommandType::FLOW_CONTROL) {
+        _flowConsumed += _flowLineLength;
+    }
+    _flowLineLength = 0;
+    _flowLastReceived = millis();
+    if (_flowConsumed >= kFlowWindow / 2) {
+        _sendCredits();
+    }
+}
+
+void SerialTwoWireSlave::_pollFlowControl()
+{
+    if (_flowConsumed && flags()._getCommand() == CommandType::NONE && data()._length == 0 && (uint32_t)(millis() - _flowLastReceived) >= I2C_OVER_UART_FLOW_IDLE_TIME) {
+        _sendCredits();
+    }
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+
+static void _writeUInt32(SerialTwoWireStream &stream, uint32_t value)
+{
+    for(int8_t shift = 24; shift >= 0; shift -= 8) {
+        stream.write((uint8_t)(value >> shift));
+    }
+}
+
+static uint32_t _readUInt32(const SerialTwoWireStream &stream, uint8_t pos)
+{
+    uint32_t value = 0;
+    for(uint8_t i = 0; i < 4; i++) {
+        value = (value << 8) | stream[pos + i];
+    }
+    return value;
+}
+
+void SerialTwoWireSlave::_sendNegotiation(NegotiationType type, uint32_t clock, uint32_t baudRate)
+{
+    if (flags()._getOutState() != OutStateType::NONE) {
+        __LDBG_printf("outs=%u", flags()._outState);
+        return;
+    }
+    beginTransmission(data()._getAddress());
+    _out.write(static_cast<uint8_t>(type));
+    _out.write(kProtocolVersion);
+    _out.write(kFeatures);
+    _out.write(kTransmissionMaxLength);
+    _writeUInt32(_out, clock);
+    _writeUInt32(_out, baudRate);
+    _endTransmission(CommandStringType::NEGOTIATE, true);
+}
+
+void SerialTwoWireSlave::_processNegotiation()
+{
+    // sender address and capabilities
+    if (!flags()._inState || _in.length() != kNegotiationLength + 1) {
+        return;
+    }
+    auto type = static_cast<NegotiationType>(_in[1]);
+    auto baudRate = _readUInt32(_in, 9);
+    __LDBG_printf("type=%u version=%u features=%02x baud=%u", _in[1], _in[2], _in[3], baudRate);
+    switch(type) {
+    case NegotiationType::REQUEST: {
+            _peer._version = _in[2];
+            _peer._features = _in[3];
+            _peer._maxLength = _in[4];
+            _peer._clock = _readUInt32(_in, 5);
+            _peer._baudRate = baudRate;
+            if (_peer._clock && _onClock) {
+                _onClock(_peer._clock);
+            }
+            // cannot switch if the framing is different
+            if (baudRate == _baudRate || baudRate > I2C_OVER_UART_MAX_BAUD_RATE || !_onBaudRate || ((_peer._features ^ kFeatures) & kFeatureFramingMask)) {
+                baudRate = 0;
+            }
+            _sendNegotiation(NegotiationType::RESPONSE, _peer._clock, baudRate);
+            if (baudRate && _invokeOnBaudRate(baudRate)) {
+                // revert if the master does not confirm
+                _baudRatePending = baudRate;
+                _baudRateSwitched = millis();
+            }
+        } break;
+    case NegotiationType::CONFIRM:
+        if (baudRate == _baudRatePending) {
+            // if CONFIRMED gets lost, the master reverts. keep the previous baud rate until
+            // the next valid frame has been received, usually COMMIT
+            _baudRatePrevious = _baudRate;
+            _baudRate = baudRate;
+            _baudRatePending = 0;
+            _baudRateSwitched = millis();
+            _sendNegotiation(NegotiationType::CONFIRMED, 0, baudRate);
+        }
+        break;
+    case NegotiationType::RESPONSE:
+        _peer._version = _in[2];
+        _peer._features = _in[3];
+        _peer._maxLength = _in[4];
+        _peer._clock = _readUInt32(_in, 5);
+        _peer._baudRate = baudRate;
+        _negotiationReceived = type;
+        break;
+    case NegotiationType::CONFIRMED:
+        _negotiationReceived = type;
+        break;
+    default:
+        break;
+    }
+}
+
+void SerialTwoWireSlave::_pollNegotiation()
+{
+    if (_baudRatePending && (uint32_t)(millis() - _baudRateSwitched) > I2C_OVER_UART_NEGOTIATION_TIMEOUT * 2) {
+        __LDBG_printf("baud rate %u not confirmed, revert to %u", _baudRatePending, _baudRate);
+        _baudRatePending = 0;
+        _invokeOnBaudRate(_baudRate);
+        // terminate the line the other side might have received with a different baud rate
+        // and discard the partial line received
+        _println();
+        _cleanup();
+    }
+    if (_baudRatePrevious && (uint32_t)(millis() - _baudRateSwitched) > I2C_OVER_UART_NEGOTIATION_TIMEOUT * 2) {
+        __LDBG_printf("nothing received with baud rate %u, revert to %u", _baudRate, _baudRatePrevious);
+        _baudRate = _baudRatePrevious;
+        _baudRatePrevious = 0;
+        _invokeOnBaudRate(_baudRate);
+        _println();
+        _cleanup();
+    }
+}
+
+#endif
+
 void SerialTwoWireSlave::_processData()
 {
     _preProcess();
 
     switch(flags()._getCommand()) {
     case CommandType::MASTER_REQUEST:
-        if (true) {
-            // request has address and length only
-            __LDBG_printf("requestFrom addr=%02x len=%u", data()._address, _in.charAt(0));
-            _in.clear();
-            if (flags()._getOutState() != OutStateType::NONE) {
-                // cannot accept request while requestFrom() is waiting
-                _sendNack(data()._getAddress());
-                return;
-            }
-            beginTransmission(data()._getAddress());
-            // collect data in output buffer
-            _invokeOnRequest();
-            _endTransmission(CommandStringType::SLAVE_RESPONSE, true);
-        }
+        _processRequest(data()._getAddress());
         break;
     case CommandType::MASTER_TRANSMIT:
         if (flags()._inState) {
@@ -301,11 +741,124 @@ void SerialTwoWireSlave::_processData()
             flags()._readFromOut = true;
         }
         break;
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+    case CommandType::SUBSCRIBE:
+        if (flags()._inState) {
+            _subscribe(data()._getAddress());
+        }
+        break;
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    case CommandType::FLOW_CONTROL:
+        _processCredits();
+        break;
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    case CommandType::NEGOTIATE:
+        _processNegotiation();
+        break;
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    case CommandType::ACKNOWLEDGE:
+        _processAcknowledgement();
+        break;
+#endif
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+    case CommandType::COMMAND:
+        _invokeOnCommand();
+        break;
+#endif
     default:
         break;
     }
 }
 
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+
+void SerialTwoWireSlave::_subscribe(uint8_t address)
+{
+    if (_in.length() != kSubscribeLength) {
+        __LDBG_printf("invalid subscription ilen=%u", _in.length());
+        return;
+    }
+    auto reg = _in[0];
+    auto length = _in[1];
+    auto interval = (_in[2] << 8) | _in[3];
+    auto maxInterval = (_in[4] << 8) | _in[5];
+    __LDBG_printf("subscribe addr=%02x reg=%02x len=%u interval=%u max=%u", address, reg, length, interval, maxInterval);
+
+    Subscription_t *subscription = nullptr;
+    for(auto &item: _subscriptions) {
+        if (item._length && item._address == address && item._register == reg) {
+            subscription = &item;
+            break;
+        }
+        if (!item._length && !subscription) {
+            subscription = &item;
+        }
+    }
+    if (length == 0 || length > kSubscriptionMaxLength) {
+        // unsubscribe
+        if (subscription) {
+            subscription->_length = 0;
+        }
+        return;
+    }
+    if (!subscription) {
+        __LDBG_printf("no free subscription");
+        return;
+    }
+    subscription->_address = address;
+    subscription->_register = reg;
+    subscription->_length = length;
+    subscription->_pushed = false;
+    subscription->_interval = interval;
+    subscription->_maxInterval = maxInterval;
+    subscription->_lastCheck = millis() - interval;
+}
+
+void SerialTwoWireSlave::_pollSubscriptions()
+{
+    // _in and _out are in use
+    if (flags()._inState || flags()._getOutState() != OutStateType::NONE) {
+        return;
+    }
+    uint32_t now = millis();
+    for(auto &item: _subscriptions) {
+        if (!item._length || (uint32_t)(now - item._lastCheck) < item._interval) {
+            continue;
+        }
+        item._lastCheck = now;
+
+        // write register pointer
+        _in.clear();
+        _in.write(item._register);
+        _invokeOnReceive(1);
+        _in.clear();
+
+        // read value, the register is sent in front of the data
+        beginTransmission(item._address);
+        _out.write(item._register);
+        _invokeOnRequest();
+        while (_out.length() > item._length + 2) {
+            _out.pop_back();
+        }
+        auto value = _out.begin() + 2;
+        if (_out.length() == item._length + 2 && (!item._pushed || memcmp(item._value, value, item._length) != 0 || (item._maxInterval && (uint32_t)(now - item._lastPush) >= item._maxInterval))) {
+            memcpy(item._value, value, item._length);
+            item._pushed = true;
+            item._lastPush = now;
+            _endTransmission(CommandStringType::SLAVE_PUSH, true);
+        }
+        else {
+            _out.clear();
+            flags()._setOutState(OutStateType::NONE);
+        }
+    }
+}
+
+#endif
+
 const char *SerialTwoWireSlave::getCommandStr(CommandStringType type)
 {
     static char buf[8];
@@ -314,6 +867,36 @@ const char *SerialTwoWireSlave::getCommandStr(CommandStringType type)
         case CommandStringType::SLAVE_RESPONSE:
 #if !I2C_OVER_UART_SLAVE_RESPONSE_MASTER_TRANSMIT
         case CommandStringType::MASTER_TRANSMIT:
+#endif
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+        case CommandStringType::SUBSCRIBE:
+        case CommandStringType::SLAVE_PUSH:
+#endif
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+        case CommandStringType::SLAVE_BUSY:
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+        case CommandStringType::TOKEN:
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+        case CommandStringType::FLOW_CONTROL:
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+        case CommandStringType::NEGOTIATE:
+#endif
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+        case CommandStringType::PROGRAM:
+        case CommandStringType::RUN_PROGRAM:
+#endif
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+        case CommandStringType::MULTI_READ:
+#endif
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+        case CommandStringType::COMPRESSED_TRANSMIT:
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+        case CommandStringType::SEQUENCED_TRANSMIT:
+        case CommandStringType::ACKNOWLEDGE:
 #endif
             snprintf_P(buf, sizeof(buf), PSTR("+I2C%c="), type);
             return buf;
@@ -343,6 +926,60 @@ SerialTwoWireSlave::CommandStringType SerialTwoWireSlave::getCommandStringType(c
         if (strcasecmp(str, getCommandStr(CommandStringType::MASTER_TRANSMIT)) == 0) {
             return CommandStringType::MASTER_TRANSMIT;
         }
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+        if (strcasecmp(str, getCommandStr(CommandStringType::SUBSCRIBE)) == 0) {
+            return CommandStringType::SUBSCRIBE;
+        }
+        if (strcasecmp(str, getCommandStr(CommandStringType::SLAVE_PUSH)) == 0) {
+            return CommandStringType::SLAVE_PUSH;
+        }
+#endif
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+        if (strcasecmp(str, getCommandStr(CommandStringType::SLAVE_BUSY)) == 0) {
+            return CommandStringType::SLAVE_BUSY;
+        }
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+        if (strcasecmp(str, getCommandStr(CommandStringType::TOKEN)) == 0) {
+            return CommandStringType::TOKEN;
+        }
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+        if (strcasecmp(str, getCommandStr(CommandStringType::FLOW_CONTROL)) == 0) {
+            return CommandStringType::FLOW_CONTROL;
+        }
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+        if (strcasecmp(str, getCommandStr(CommandStringType::NEGOTIATE)) == 0) {
+            return CommandStringType::NEGOTIATE;
+        }
+#endif
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+        if (strcasecmp(str, getCommandStr(CommandStringType::PROGRAM)) == 0) {
+            return CommandStringType::PROGRAM;
+        }
+        if (strcasecmp(str, getCommandStr(CommandStringType::RUN_PROGRAM)) == 0) {
+            return CommandStringType::RUN_PROGRAM;
+        }
+#endif
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+        if (strcasecmp(str, getCommandStr(CommandStringType::MULTI_READ)) == 0) {
+            return CommandStringType::MULTI_READ;
+        }
+#endif
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+        if (strcasecmp(str, getCommandStr(CommandStringType::COMPRESSED_TRANSMIT)) == 0) {
+            return CommandStringType::COMPRESSED_TRANSMIT;
+        }
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+        if (strcasecmp(str, getCommandStr(CommandStringType::SEQUENCED_TRANSMIT)) == 0) {
+            return CommandStringType::SEQUENCED_TRANSMIT;
+        }
+        if (strcasecmp(str, getCommandStr(CommandStringType::ACKNOWLEDGE)) == 0) {
+            return CommandStringType::ACKNOWLEDGE;
+        }
+#endif
     }
     return CommandStringType::NONE;
 }
@@ -382,25 +1019,378 @@ uint8_t SerialTwoWireSlave::endTransmission(uint8_t stop)
 
 uint8_t SerialTwoWireSlave::_endTransmission(CommandStringType type, uint8_t stop)
 {
-    auto iter = _out.begin();
-    auto end = _out.end();
-#if I2C_OVER_UART_ADD_CRC16
-    uint16_t crc = crc16_update(iter, end - iter);
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    if (type != CommandStringType::FLOW_CONTROL) {
+        _waitForCredits(_getFrameLength(_out.length()));
+    }
 #endif
     // write as fast as possible
     _serial->flush();
-    sendCommandStr(*_serial, type);
-    for (; iter != end; ++iter) {
-        _printHex(*iter);
-    }
-#if I2C_OVER_UART_ADD_CRC16
-    _printHexCrc(crc);
-#else
-    _println();
-#endif
+    _printFrame(type, _out.begin(), _out.length());
     _serial->flush();
     _out.clear();
     flags()._setOutState(OutStateType::NONE);
 
     return static_cast<uint8_t>(EndTransmissionCode::SUCCESS);
 }
+
+bool SerialTwoWireSlave::_printFrame(CommandStringType type, const uint8_t *data, size_t length)
+{
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY || I2C_OVER_UART_ENABLE_COMPRESSION
+    bool complete;
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    if (type == CommandStringType::MASTER_TRANSMIT && _printSequencedFrame(data, length, complete)) {
+        return complete;
+    }
+#endif
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+    if (type == CommandStringType::MASTER_TRANSMIT && _printCompressedFrame(data, length, complete)) {
+        return complete;
+    }
+#endif
+    size_t written = _printCommand(type);
+#if I2C_OVER_UART_ADD_CRC16
+    checksum_t crc = Checksum::kInit;
+    for (auto ptr = data, end = data + length; ptr != end; ++ptr) {
+        written += _printHexUpdateCrc(*ptr, crc);
+    }
+    written += _printHexCrc(crc);
+#else
+    for (auto ptr = data, end = data + length; ptr != end; ++ptr) {
+        written += _printHex(*ptr);
+    }
+    written += _println();
+#endif
+    return written == _getFrameLength(length);
+}
+
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+
+void SerialTwoWireSlave::_addCompressed(uint8_t byte, size_t maxLength)
+{
+    if (!_decoder.decode(byte, _in, maxLength)) {
+        __LDBG_printf("data=%u ilen=%u max=%u", byte, _in.length(), maxLength);
+        _discard();
+    }
+}
+
+bool SerialTwoWireSlave::_printCompressedFrame(const uint8_t *data, size_t length, bool &complete)
+{
+    // the first byte is the address and not compressed
+    if (length < kCompressionMinLength + 1) {
+        return false;
+    }
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    if (_peer._version && !(_peer._features & kFeatureCompression)) {
+        return false;
+    }
+#endif
+    auto size = SerialTwoWireCompression::compress(data + 1, length - 1, [](uint8_t) {});
+    if (size + 1 >= length) {
+        return false;
+    }
+    _compressionStats._frames++;
+    _compressionStats._bytes += length - 1;
+    _compressionStats._compressed += size;
+
+    size_t written = _printCommand(CommandStringType::COMPRESSED_TRANSMIT);
+#if I2C_OVER_UART_ADD_CRC16
+    checksum_t crc = Checksum::kInit;
+    written += _printHexUpdateCrc(*data, crc);
+    SerialTwoWireCompression::compress(data + 1, length - 1, [&](uint8_t byte) {
+        written += _printHexUpdateCrc(byte, crc);
+    });
+#else
+    written += _printHex(*data);
+    SerialTwoWireCompression::compress(data + 1, length - 1, [&](uint8_t byte) {
+        written += _printHex(byte);
+    });
+#endif
+#if I2C_OVER_UART_ADD_CRC16
+    written += _printHexCrc(crc);
+#else
+    written += _println();
+#endif
+    complete = (written == _getFrameLength(size + 1));
+    return true;
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_FEC
+
+bool SerialTwoWireSlave::_fecCorrect()
+{
+    if (flags()._getCommand() <= CommandType::DISCARD) {
+        return false;
+    }
+    auto result = SerialTwoWireFec::ResultType::NONE;
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+    // additional commands are sent without parity bytes
+    if (flags()._getCommand() != CommandType::COMMAND)
+#endif
+    {
+        _fecStats._frames++;
+        result = SerialTwoWireFec::correct(_fecBuffer, _fecLength);
+        if (result == SerialTwoWireFec::ResultType::UNCORRECTABLE) {
+            __LDBG_printf("discard fec len=%u", _fecLength);
+            _fecStats._uncorrectable++;
+            _discard();
+            return false;
+        }
+        _fecLength -= SerialTwoWireFec::kLength;
+    }
+#if I2C_OVER_UART_ADD_CRC16
+    // detects wrong corrections of multiple errors
+    auto crc = SerialTwoWireChecksum::calculate<Checksum>(_fecBuffer, _fecLength);
+    if (crc != _fecChecksum) {
+        __LDBG_printf("discard crc=%04x _fecChecksum=%04x", crc, _fecChecksum);
+        _fecStats._uncorrectable++;
+        _discard();
+        return false;
+    }
+#endif
+    if (result == SerialTwoWireFec::ResultType::CORRECTED) {
+        _fecStats._corrected++;
+    }
+    return true;
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+
+bool SerialTwoWireSlave::_printSequencedFrame(const uint8_t *data, size_t length, bool &complete)
+{
+    if (!SerialTwoWireRetransmit::isValidLength(length)) {
+        // sent without sequence number
+        __LDBG_printf("len=%u exceeds retransmit buffer", length);
+        return false;
+    }
+    _waitForAcknowledgement(length);
+    auto frame = _retransmit.push(data, length);
+    complete = _printFrame(CommandStringType::SEQUENCED_TRANSMIT, frame, length + kSequenceLength);
+    return true;
+}
+
+void SerialTwoWireSlave::_waitForAcknowledgement(uint8_t length)
+{
+    // cannot wait while processing received data
+    if (!_retransmit.fits(length) && !flags()._processing) {
+        __LDBG_printf("wait ack len=%u", length);
+        auto start = millis();
+        while (!_retransmit.fits(length) && (uint32_t)(millis() - start) < I2C_OVER_UART_RETRANSMIT_WAIT) {
+            _wait(start, I2C_OVER_UART_RETRANSMIT_WAIT);
+            _pollRetransmit();
+        }
+    }
+    while (!_retransmit.fits(length)) {
+        __LDBG_printf("drop oldest frame len=%u", length);
+        _retransmit.dropOldest();
+    }
+}
+
+bool SerialTwoWireSlave::_receiveSequenced(uint8_t offset)
+{
+    if (_in.length() < offset + kSequenceLength) {
+        __LDBG_printf("discard ilen=%u", _in.length());
+        _discard();
+        return false;
+    }
+    auto session = _in[offset];
+    auto sequence = _in[offset + 1];
+    auto ptr = _in.begin() + offset;
+    memmove(ptr, ptr + kSequenceLength, _in.length() - offset - kSequenceLength);
+    _in.pop_back();
+    _in.pop_back();
+
+    if ((sequence & SerialTwoWireRetransmit::kSyncFlag) && (!_sequenceSynced || session != _sequenceSession)) {
+        // first frame of a new session
+        _sequenceSession = session;
+        _sequenceNext = sequence & SerialTwoWireRetransmit::kSequenceMask;
+        _sequenceSynced = true;
+    }
+    bool deliver = false;
+    if (!_sequenceSynced || session != _sequenceSession) {
+        // the acknowledgement requests a new session
+        __LDBG_printf("unknown session=%02x", session);
+        _sequenceStats._resync++;
+        _sequenceSession = session;
+        _sequenceSynced = false;
+    }
+    else {
+        uint8_t distance = (sequence - _sequenceNext) & SerialTwoWireRetransmit::kSequenceMask;
+        if (distance == 0) {
+            _sequenceNext = (_sequenceNext + 1) & SerialTwoWireRetransmit::kSequenceMask;
+            _sequenceStats._received++;
+            deliver = true;
+        }
+        else if (distance < SerialTwoWireRetransmit::kWindow) {
+            // a previous frame is missing, the sender will retransmit all of them
+            __LDBG_printf("out of order seq=%u next=%u", sequence & SerialTwoWireRetransmit::kSequenceMask, _sequenceNext);
+            _sequenceStats._outOfOrder++;
+        }
+        else {
+            __LDBG_printf("duplicate seq=%u next=%u", sequence & SerialTwoWireRetransmit::kSequenceMask, _sequenceNext);
+            _sequenceStats._duplicates++;
+        }
+    }
+    _sendAcknowledgement();
+    if (!deliver) {
+        _discard();
+    }
+    return deliver;
+}
+
+void SerialTwoWireSlave::_sendAcknowledgement()
+{
+    // _out might be in use, the frame is short enough to be sent directly
+    uint8_t frame[3] = {
+        data()._getAddress(),
+        _sequenceSession,
+        _sequenceSynced ? _sequenceNext : SerialTwoWireRetransmit::kSyncFlag
+    };
+    _printFrame(CommandStringType::ACKNOWLEDGE, frame, sizeof(frame));
+}
+
+void SerialTwoWireSlave::_processAcknowledgement()
+{
+    // sender address, session and next sequence number
+    if (flags()._inState && _in.length() == 3) {
+        if (_retransmit.acknowledge(_in[1], _in[2])) {
+            _retransmitFrames();
+        }
+    }
+}
+
+void SerialTwoWireSlave::_retransmitFrames()
+{
+    _retransmit.retransmit([this](const uint8_t *frame, uint8_t length) {
+        _printFrame(CommandStringType::SEQUENCED_TRANSMIT, frame, length);
+    });
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+
+void SerialTwoWireSlave::_pollRemarks()
+{
+    _remark.poll([this](const uint8_t *text, uint16_t length) {
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+        uint16_t frameLength = length + SerialTwoWireRemark::kCommandLength;
+        if (_flowCredits < (frameLength > kFlowWindow ? kFlowWindow : frameLength)) {
+            return false;
+        }
+        _flowCredits = _flowCredits > frameLength ? _flowCredits - frameLength : 0;
+#endif
+        _write('+');
+        _write('R');
+        _write('E');
+        _write('M');
+        _write('=');
+        for(auto end = text + length; text != end; ++text) {
+            _write(*text);
+        }
+        _println();
+        return true;
+    });
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+
+bool SerialTwoWireSlave::addCommandHandler(const char *command, onCommandCallback callback)
+{
+    // the header is matched while it is received. the headers of the protocol and any prefix
+    // of them are reserved, a handler for "+I2CT" would receive all transmissions
+    char header[kCommandMaxLength + 2];
+    auto length = strlen(command);
+    bool reserved = false;
+    if (length <= 4) {
+        reserved = strncasecmp_P(command, PSTR("+I2C"), length) == 0;
+    }
+    else if (length <= kCommandMaxLength) {
+        strcpy(header, command);
+        strcpy(header + length, "=");
+        reserved = getCommandStringType(command) != CommandStringType::NONE || getCommandStringType(header) != CommandStringType::NONE;
+    }
+    if (*command != '+' || length < 2 || length > kCommandMaxLength || reserved) {
+        __LDBG_printf("invalid command=%s", command);
+        return false;
+    }
+    CommandHandler_t *handler = nullptr;
+    for(auto &item: _commandHandlers) {
+        if (item._command && strcasecmp(item._command, command) == 0) {
+            handler = &item;
+            break;
+        }
+        if (!item._command && !handler) {
+            handler = &item;
+        }
+    }
+    if (!handler) {
+        __LDBG_printf("no free handler command=%s", command);
+        return false;
+    }
+    handler->_command = command;
+    handler->_callback = callback;
+    return true;
+}
+
+void SerialTwoWireSlave::removeCommandHandler(const char *command)
+{
+    for(auto &item: _commandHandlers) {
+        if (item._command && strcasecmp(item._command, command) == 0) {
+            item._command = nullptr;
+            item._callback = nullptr;
+        }
+    }
+}
+
+void SerialTwoWireSlave::_findCommandHandler()
+{
+    for(uint8_t i = 0; i < kCommandHandlers; i++) {
+        auto command = _commandHandlers[i]._command;
+        if (command && strcasecmp(reinterpret_cast<const char *>(_buffer), command) == 0) {
+            flags()._setCommand(CommandType::COMMAND);
+            // the data has no address
+            flags()._inState = true;
+            _commandHandler = i;
+            data()._length = 0;
+            _newTransmission();
+            return;
+        }
+    }
+}
+
+void SerialTwoWireSlave::_beginUnknownLine(uint8_t byte)
+{
+    if (!_onUnknownLine) {
+        return;
+    }
+    flags()._unknownLine = true;
+    if (data()._length) {
+        _onUnknownLine(_buffer, data()._length, false);
+    }
+    _onUnknownLine(&byte, 1, false);
+}
+
+void SerialTwoWireSlave::_endUnknownLine()
+{
+    if (flags()._getCommand() == CommandType::NONE && data()._length && _onUnknownLine) {
+        // shorter than any command
+        flags()._unknownLine = true;
+        _onUnknownLine(_buffer, data()._length, false);
+    }
+    if (flags()._unknownLine) {
+        flags()._unknownLine = false;
+        if (_onUnknownLine) {
+            _onUnknownLine(nullptr, 0, true);
+        }
+    }
+}
+
+#endif
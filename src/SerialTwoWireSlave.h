@@ -8,6 +8,27 @@
 #include "SerialTwoWireDef.h"
 #include "SerialTwoWireStream.h"
 #include "SerialTwoWireDebug.h"
+#if I2C_OVER_UART_ADD_CRC16
+#include "SerialTwoWireChecksum.h"
+#endif
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+#include "SerialTwoWireCompression.h"
+#endif
+#if I2C_OVER_UART_ENABLE_FEC
+#include "SerialTwoWireFec.h"
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+#include "SerialTwoWireRetransmit.h"
+#endif
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+#include "SerialTwoWireRemark.h"
+#endif
+#if I2C_OVER_UART_ENABLE_RX_RING
+#include "SerialTwoWireRing.h"
+#endif
+#if I2C_OVER_UART_ENABLE_WAITER
+#include "SerialTwoWireWaiter.h"
+#endif
 
 #if DEBUG_SERIALTWOWIRE
 #include <debug_helper.h>
@@ -55,6 +76,62 @@ public:
     typedef void (*onReadSerialCallback)();
 #endif
 
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+#if I2C_OVER_UART_USE_STD_FUNCTION
+    using onCommandCallback = std::function<void(int)>;
+    using onUnknownLineCallback = std::function<void(const uint8_t *, size_t, bool)>;
+#else
+    typedef void (*onCommandCallback)(int length);
+    // called with parts of the line and complete set to true with length 0 at the end
+    typedef void (*onUnknownLineCallback)(const uint8_t *data, size_t length, bool complete);
+#endif
+
+    static constexpr uint8_t kCommandHandlers = I2C_OVER_UART_COMMAND_HANDLERS;
+#endif
+
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+#if I2C_OVER_UART_USE_STD_FUNCTION
+    using onBaudRateCallback = std::function<bool(uint32_t)>;
+    using onClockCallback = std::function<void(uint32_t)>;
+#else
+    typedef bool (*onBaudRateCallback)(uint32_t baudRate);
+    typedef void (*onClockCallback)(uint32_t clock);
+#endif
+
+    static constexpr uint8_t kProtocolVersion = 1;
+
+    static constexpr uint8_t kFeatureCrc16 = 0x01;
+    static constexpr uint8_t kFeatureSlaveResponseMasterTransmit = 0x02;
+    static constexpr uint8_t kFeatureSubscriptions = 0x04;
+    static constexpr uint8_t kFeatureDeferredResponse = 0x08;
+    static constexpr uint8_t kFeatureTokenRing = 0x10;
+    static constexpr uint8_t kFeatureFlowControl = 0x20;
+    static constexpr uint8_t kFeatureCompression = 0x40;
+    static constexpr uint8_t kFeatureFec = 0x80;
+    // features that change the framing and must be the same on both sides
+    static constexpr uint8_t kFeatureFramingMask = kFeatureCrc16 | kFeatureSlaveResponseMasterTransmit | kFeatureFec;
+
+    static constexpr uint8_t kFeatures =
+        (I2C_OVER_UART_ADD_CRC16 ? kFeatureCrc16 : 0) |
+        (I2C_OVER_UART_SLAVE_RESPONSE_MASTER_TRANSMIT ? kFeatureSlaveResponseMasterTransmit : 0) |
+        (I2C_OVER_UART_ENABLE_SUBSCRIPTIONS ? kFeatureSubscriptions : 0) |
+        (I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE ? kFeatureDeferredResponse : 0) |
+        (I2C_OVER_UART_ENABLE_TOKEN_RING ? kFeatureTokenRing : 0) |
+        (I2C_OVER_UART_ENABLE_FLOW_CONTROL ? kFeatureFlowControl : 0) |
+        (I2C_OVER_UART_ENABLE_COMPRESSION ? kFeatureCompression : 0) |
+        (I2C_OVER_UART_ENABLE_FEC ? kFeatureFec : 0);
+
+    struct Capabilities {
+        uint8_t _version;                           // 0 = no negotiation received
+        uint8_t _features;
+        uint8_t _maxLength;                         // max. input length
+        uint32_t _clock;                            // requested I2C clock, 0 = unchanged
+        uint32_t _baudRate;                         // requested or accepted baud rate, 0 = unchanged
+
+        Capabilities() : _version(0), _features(0), _maxLength(0), _clock(0), _baudRate(0) {}
+    };
+#endif
+
 protected:
     enum class CommandStringType : char {
         NONE,
@@ -64,6 +141,36 @@ protected:
         SLAVE_RESPONSE = 'T',
 #else
         SLAVE_RESPONSE = 'A',
+#endif
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+        SUBSCRIBE = 'U',
+        SLAVE_PUSH = 'P',
+#endif
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+        SLAVE_BUSY = 'B',
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+        TOKEN = 'K',
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+        FLOW_CONTROL = 'F',
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+        NEGOTIATE = 'N',
+#endif
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+        PROGRAM = 'M',
+        RUN_PROGRAM = 'X',
+#endif
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+        MULTI_READ = 'Q',
+#endif
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+        COMPRESSED_TRANSMIT = 'Z',
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+        SEQUENCED_TRANSMIT = 'L',     // 'S' is used by the bus scan of the examples
+        ACKNOWLEDGE = 'W',
 #endif
     };
 
@@ -73,7 +180,7 @@ protected:
         // discard transmission
         DISCARD,
 
-        // transmit from slave after requestFrom() -> _request(_out) buffer
+        // transmit from slave after requestFrom() -> _request(_response) buffer
         // the data is available for read until a new request or transmission is started
         // the data will be removed from the buffer at this point
         // or
@@ -88,6 +195,59 @@ protected:
         // response from slave -> _out
         // data can only be read/written inside the onRequest callback
         SLAVE_RESPONSE,
+
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+        // subscription from master -> _in
+        SUBSCRIBE,
+
+        // value pushed by slave -> _in
+        // data can only be read inside the onPush callback
+        SLAVE_PUSH,
+#endif
+
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+        // busy response from slave -> _in
+        SLAVE_BUSY,
+#endif
+
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+        // token passed between masters -> _in
+        TOKEN,
+#endif
+
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+        // credits from the receiver -> _in
+        FLOW_CONTROL,
+#endif
+
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+        // capabilities and link settings -> _in
+        NEGOTIATE,
+#endif
+
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+        // program upload from master -> _in
+        PROGRAM,
+
+        // run program request from master -> _in
+        RUN_PROGRAM,
+#endif
+
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+        // multi read request from master -> _in
+        MULTI_READ,
+#endif
+
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+        // acknowledgement of sequenced transmissions -> _in
+        ACKNOWLEDGE,
+#endif
+
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+        // command of a handler -> _in
+        // data can only be read inside the callback of the handler
+        COMMAND,
+#endif
     };
 
     enum class OutStateType : uint8_t {
@@ -114,13 +274,24 @@ protected:
         uint8_t _address;                                   // own address
         uint8_t _length;                                    // _buffer.length
 #if I2C_OVER_UART_ADD_CRC16
-        uint16_t _crc;
+        checksum_t _crc;
 #endif
         CommandType _command;
         OutStateType _outState;                     // _out buffer state
-        bool _readFromOut;                          // read from _out or _in
+        OutStateType _requestState;                 // _response buffer state (master)
+        bool _readFromOut;                          // read from _response or _in
         bool _crcMarker;                            // crc marker received
         bool _inState;                              // _in buffer state
+        bool _processing;                           // processing received data
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+        bool _compressed;                           // _in is filled by _decoder
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+        bool _sequenced;                            // _in starts with session and sequence number
+#endif
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+        bool _unknownLine;                          // the line is passed to _onUnknownLine
+#endif
 
         String _getCommandAsString() const {
             switch(_command) {
@@ -134,6 +305,46 @@ protected:
                     return F("MASTER_TRANSMIT");
                 case CommandType::SLAVE_RESPONSE:
                     return F("SLAVE_RESPONSE");
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+                case CommandType::SUBSCRIBE:
+                    return F("SUBSCRIBE");
+                case CommandType::SLAVE_PUSH:
+                    return F("SLAVE_PUSH");
+#endif
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+                case CommandType::SLAVE_BUSY:
+                    return F("SLAVE_BUSY");
+#endif
+#if I2C_OVER_UART_ENABLE_TOKEN_RING
+                case CommandType::TOKEN:
+                    return F("TOKEN");
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+                case CommandType::FLOW_CONTROL:
+                    return F("FLOW_CONTROL");
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+                case CommandType::NEGOTIATE:
+                    return F("NEGOTIATE");
+#endif
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+                case CommandType::PROGRAM:
+                    return F("PROGRAM");
+                case CommandType::RUN_PROGRAM:
+                    return F("RUN_PROGRAM");
+#endif
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+                case CommandType::MULTI_READ:
+                    return F("MULTI_READ");
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+                case CommandType::ACKNOWLEDGE:
+                    return F("ACKNOWLEDGE");
+#endif
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+                case CommandType::COMMAND:
+                    return F("COMMAND");
+#endif
             }
             return F("INVALID");
         }
@@ -156,30 +367,176 @@ protected:
             _outState = state;
         }
 
+        OutStateType _getRequestState() const {
+            return _requestState;
+        }
+
+        void _setRequestState(OutStateType state) {
+            _requestState = state;
+        }
+
         bool _outCanWrite() const {
-            return _getOutState() == OutStateType::LOCKED || _getOutState() == OutStateType::FILLING;
+            return _getOutState() == OutStateType::LOCKED;
         }
 
-        bool _outIsFilling() const {
-            return _getOutState() == OutStateType::FILL || _getOutState() == OutStateType::FILLING;
+        bool _requestIsFilling() const {
+            return _getRequestState() == OutStateType::FILL || _getRequestState() == OutStateType::FILLING;
         }
 
         Data_t() :
             _address(kNotInitializedAddress),
             _length(0),
 #if I2C_OVER_UART_ADD_CRC16
-            _crc(~0),
+            _crc(Checksum::kInit),
 #endif
             _command(CommandType::NONE),
             _outState(OutStateType::NONE),
+            _requestState(OutStateType::NONE),
             _readFromOut(true),
             _crcMarker(0),
-            _inState(false)
+            _inState(false),
+            _processing(false)
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+            , _compressed(false)
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+            , _sequenced(false)
+#endif
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+            , _unknownLine(false)
+#endif
         {
         }
 
     };
 
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    static constexpr uint16_t kFlowWindow = I2C_OVER_UART_FLOW_WINDOW;
+
+    struct FlowStats {
+        uint32_t _waits;                            // not enough credits
+        uint32_t _timeouts;                         // credits reset after timeout
+        uint32_t _updatesSent;
+        uint32_t _updatesReceived;
+
+        FlowStats() : _waits(0), _timeouts(0), _updatesSent(0), _updatesReceived(0) {}
+    };
+#endif
+
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+    static constexpr uint8_t kCompressionMinLength = I2C_OVER_UART_COMPRESSION_MIN_LENGTH;
+
+    struct CompressionStats {
+        uint32_t _frames;                           // compressed frames sent
+        uint32_t _bytes;                            // size of the transmissions
+        uint32_t _compressed;                       // size after compression
+        uint32_t _received;                         // compressed frames received
+
+        CompressionStats() : _frames(0), _bytes(0), _compressed(0), _received(0) {}
+    };
+#endif
+
+#if I2C_OVER_UART_ENABLE_FEC
+    static constexpr uint8_t kFecBufferSize = I2C_OVER_UART_FEC_BUFFER_SIZE;
+    static constexpr uint8_t kFecCheckLength = SerialTwoWireFec::kLength;
+    static_assert(kFecBufferSize <= SerialTwoWireFec::kMaxLength, "I2C_OVER_UART_FEC_BUFFER_SIZE too big");
+#else
+    static constexpr uint8_t kFecCheckLength = 0;
+#endif
+
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    static constexpr uint8_t kSequenceLength = SerialTwoWireRetransmit::kSequenceLength;
+
+    struct SequenceStats {
+        uint32_t _received;                         // frames delivered
+        uint32_t _duplicates;
+        uint32_t _outOfOrder;                       // dropped after a lost frame
+        uint32_t _resync;                           // frames of an unknown session
+
+        SequenceStats() : _received(0), _duplicates(0), _outOfOrder(0), _resync(0) {}
+    };
+#endif
+
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+    static constexpr uint16_t kLineBufferSize = I2C_OVER_UART_LINE_BUFFER_SIZE;
+#endif
+
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+    struct CommandHandler_t {
+        const char *_command;                       // nullptr = unused
+        onCommandCallback _callback;
+    };
+#endif
+
+#if I2C_OVER_UART_ENABLE_RESYNC
+    struct ResyncStats {
+        uint32_t _headers;                          // partial lines dropped for a new line
+        uint32_t _timeouts;                         // partial lines dropped after the idle timeout
+
+        ResyncStats() : _headers(0), _timeouts(0) {}
+    };
+#endif
+
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    enum class NegotiationType : uint8_t {
+        NONE = 0,
+        REQUEST,                                    // master -> slave
+        RESPONSE,                                   // slave -> master, sent before switching the baud rate
+        CONFIRM,                                    // master -> slave using the new baud rate
+        CONFIRMED,                                  // slave -> master
+        COMMIT,                                     // master -> slave, no answer
+    };
+
+    // type, version, features, max. length, clock, baud rate
+    static constexpr uint8_t kNegotiationLength = 12;
+#endif
+
+#if I2C_OVER_UART_ENABLE_PROGRAMS
+public:
+    static constexpr uint8_t kProgramSlots = I2C_OVER_UART_PROGRAM_SLOTS;
+    static constexpr uint8_t kProgramMaxLength = I2C_OVER_UART_PROGRAM_MAX_LENGTH;
+    // program results are sent as response from kProgramAddress + slot
+    static constexpr uint8_t kProgramAddress = 0x80;
+    static_assert(kProgramSlots <= 0x70, "too many program slots");
+
+protected:
+#endif
+
+#if I2C_OVER_UART_ENABLE_MULTI_READ
+public:
+    // the results of a multi read are sent as response from this address
+    static constexpr uint8_t kMultiReadAddress = 0xf0;
+
+    struct MultiRead_t {
+        uint8_t _address;
+        uint8_t _register;
+        uint8_t _length;
+        uint8_t *_data;                             // buffer for _length byte
+        uint8_t _status;                            // EndTransmissionCode
+    };
+
+protected:
+#endif
+
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+    static constexpr uint8_t kSubscriptions = I2C_OVER_UART_SUBSCRIPTIONS;
+    static constexpr uint8_t kSubscriptionMaxLength = I2C_OVER_UART_SUBSCRIPTION_MAX_LENGTH;
+    // register, length, interval, max. interval
+    static constexpr uint8_t kSubscribeLength = 6;
+
+    struct __attribute__((packed)) Subscription_t {
+        uint8_t _address;
+        uint8_t _register;
+        uint8_t _length;                            // 0 = unused
+        bool _pushed;                               // _value is valid
+        uint16_t _interval;
+        uint16_t _maxInterval;                      // 0 = push changes only
+        uint32_t _lastCheck;
+        uint32_t _lastPush;
+        uint8_t _value[kSubscriptionMaxLength];
+    };
+#endif
+
 public:
     SerialTwoWireSlave();
 
@@ -244,6 +601,15 @@ public:
     void onRequest(onRequestCallback callback);
     void onReadSerial(onReadSerialCallback callback);
 
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+    // call inside onRequest to send the response later with respond(). if retryAfter is not 0,
+    // the master is asked to extend its timeout by retryAfter milliseconds. requests for the
+    // same address are not passed to onRequest until the response has been sent
+    void deferResponse(uint16_t retryAfter = 0);
+    uint8_t respond(uint8_t address, const uint8_t *data, size_t length);
+    bool isResponsePending() const;
+#endif
+
     size_t write(unsigned long n);
     size_t write(long n);
     size_t write(unsigned int n);
@@ -256,15 +622,96 @@ public:
     // as soon as data is available on the Serial port used for the bridge,
     // the data needs to be fed into the object. this should be executed in the
     // loop function and not inside any ISR. if using the master, the method
-    // must not called from inside an ISR
+    // must not called from inside an ISR. see feedFromISR()
     virtual void feed(uint8_t data);
 
+#if I2C_OVER_UART_ENABLE_RX_RING
+    // stores data in the receive ring and can be called from an ISR or another task.
+    // returns false if the ring is full and the data has been dropped
+    bool feedFromISR(uint8_t data);
+    size_t feedFromISR(const uint8_t *data, size_t length);
+    // passes the data of the receive ring to feed(data), called by poll() and while
+    // the master is waiting for a response
+    void feed();
+    // bytes stored and dropped
+    const SerialTwoWireRing::Stats &getRingStats() const;
+#endif
+
+#if I2C_OVER_UART_ENABLE_WAITER
+    // blocking methods call waiter->wait() instead of optimistic_yield() while waiting for data.
+    // the waiter is not copied, nullptr restores the default
+    void setWaiter(SerialTwoWireWaiter *waiter);
+#endif
+
+    // must be called inside loop() if subscriptions, flow control, negotiation or reliable delivery are enabled
+    void poll();
+
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    // the callback changes the baud rate of the serial port and returns false if it is not supported
+    void onBaudRate(onBaudRateCallback callback);
+    // the callback sets the clock of the I2C bus requested with setClock() by the other side
+    void onClock(onClockCallback callback);
+    // capabilities received with the last negotiation
+    const Capabilities &getPeerCapabilities() const;
+    uint32_t getBaudRate() const;
+#endif
+
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    // number of bytes the other side can receive
+    uint16_t getCredits() const;
+    const FlowStats &getFlowStats() const;
+#endif
+
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+    const CompressionStats &getCompressionStats() const;
+#endif
+
+#if I2C_OVER_UART_ENABLE_FEC
+    // number of received frames, corrected frames and frames that could not be corrected
+    const SerialTwoWireFec::Stats &getFecStats() const;
+#endif
+
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    // sent, acknowledged and retransmitted frames
+    const SerialTwoWireRetransmit::Stats &getRetransmitStats() const;
+    // received, duplicate and out of order frames
+    const SequenceStats &getSequenceStats() const;
+#endif
+
+#if I2C_OVER_UART_ENABLE_RESYNC
+    // number of partial lines that have been dropped
+    const ResyncStats &getResyncStats() const;
+#endif
+
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+    // call callback for lines starting with command, for example "+PING" or "+LED=". the
+    // data is hex encoded like transmissions and can be read inside the callback. the command
+    // is not copied and must not be a protocol header. returns false if the command is invalid
+    // or no handler is available
+    bool addCommandHandler(const char *command, onCommandCallback callback);
+    void removeCommandHandler(const char *command);
+    // lines that are not commands are passed to the callback while they are received,
+    // for example +REM or debug output of the other side
+    void onUnknownLine(onUnknownLineCallback callback);
+#endif
+
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+    // text printed to this object is sent as +REM between frames by poll()
+    // Wire.remark().println(F("text"));
+    SerialTwoWireRemark &remark();
+#endif
+
     Stream *getSerial() const;
     Stream &getSerial();
 
 protected:
     void _end();
+#if I2C_OVER_UART_ENABLE_RESYNC
+    // called by _pollResync() for master and bridge
+    virtual void _newLine();
+#else
     void _newLine();
+#endif
     void _addBuffer(int data);
     int _parseData(bool lastByte = false);
     void _processData();
@@ -273,9 +720,92 @@ protected:
     void _preProcess();
     void _cleanup();
     void _sendNack(uint8_t address);
+    void _processRequest(uint8_t address);
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    void _sendNegotiation(NegotiationType type, uint32_t clock, uint32_t baudRate);
+    void _processNegotiation();
+    void _pollNegotiation();
+    // a valid frame has been received, the confirmed baud rate works in both directions
+    void _commitBaudRate();
+    bool _invokeOnBaudRate(uint32_t baudRate);
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    // returns false if no credits update has been received within the timeout
+    bool _waitForCredits(uint16_t length);
+    void _sendCredits();
+    void _processCredits();
+    void _flowNewLine();
+    void _pollFlowControl();
+#endif
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+    void _beginCompressed();
+    void _addCompressed(uint8_t data, size_t maxLength);
+    // returns false if the frame cannot be compressed. complete is false if it has not been
+    // written completely
+    bool _printCompressedFrame(const uint8_t *data, size_t length, bool &complete);
+#endif
+#if I2C_OVER_UART_ENABLE_FEC
+    // correct the received frame, returns false if it has been discarded
+    bool _fecCorrect();
+    size_t _printFec();
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    bool _printSequencedFrame(const uint8_t *data, size_t length, bool &complete);
+    void _waitForAcknowledgement(uint8_t length);
+    // remove the session and sequence number at offset of _in. returns false if the
+    // frame has been discarded
+    bool _receiveSequenced(uint8_t offset);
+    void _sendAcknowledgement();
+    void _processAcknowledgement();
+    void _retransmitFrames();
+    void _pollRetransmit();
+#endif
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+    // write the line buffer to the serial port
+    void _flushLine();
+    void _pollRemarks();
+#endif
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+    // called if the received header does not match any built-in command
+    void _findCommandHandler();
+    void _invokeOnCommand();
+    // the line in _buffer and byte are not a command
+    void _beginUnknownLine(uint8_t byte);
+    void _forwardUnknownLine(uint8_t byte);
+    void _endUnknownLine();
+#endif
+#if I2C_OVER_UART_ENABLE_RESYNC
+    bool _isPartialLine() const;
+    // drops the partial line if byte starts a new one or after the idle timeout. returns true
+    // if the parser has been restarted
+    bool _resync(uint8_t byte);
+    void _pollResync();
+#endif
+
+    // number of bytes sent for a transmission with length bytes including the address
+    static constexpr uint16_t _getFrameLength(uint16_t length) {
+#if I2C_OVER_UART_ADD_CRC16
+        return kRequestCommandLength + ((length + kFecCheckLength) * 2) + kChecksumLength + 2;
+#else
+        return kRequestCommandLength + ((length + kFecCheckLength) * 2) + 1;
+#endif
+    }
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+    void _sendBusy(uint8_t address);
+#endif
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+    void _subscribe(uint8_t address);
+    void _pollSubscriptions();
+#endif
 
+    // all output of frames is written with _write()
+    size_t _write(uint8_t data);
+    size_t _printCommand(CommandStringType type);
     size_t _printHex(uint8_t data);
     size_t _printNibble(uint8_t nibble);
+    // convert hex digits without checking, feed() accepts isxdigit() only
+    static uint8_t _parseNibble(uint8_t ch);
+    static uint8_t _parseHex(const uint8_t *str);
     size_t _println();
 
 #if DEBUG_SERIALTWOWIRE
@@ -297,8 +827,8 @@ protected:
 #endif
 
 #if I2C_OVER_UART_ADD_CRC16
-    size_t _printHexCrc(uint16_t crc);
-    size_t _printHexUpdateCrc(uint8_t data, uint16_t = flags()._crc);
+    size_t _printHexCrc(checksum_t crc);
+    size_t _printHexUpdateCrc(uint8_t data, checksum_t &crc);
 #endif
 
 protected:
@@ -307,6 +837,8 @@ protected:
     void _invokeOnReceive(int len);
     void _invokeOnRequest();
     void _invokeOnReadSerial();
+    // wait for data up to timeout milliseconds after start and call the onReadSerial callback
+    void _wait(uint32_t start, uint32_t timeout);
 
     static size_t sendCommandStr(Stream &stream, CommandStringType type);
     static const char *getCommandStr(CommandStringType type);
@@ -330,6 +862,71 @@ protected:
 
     Stream *_serial;
 
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+    Subscription_t _subscriptions[kSubscriptions];
+#endif
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+    uint8_t _deferredAddress;
+    uint16_t _deferredRetryAfter;
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    onBaudRateCallback _onBaudRate = nullptr;
+    onClockCallback _onClock = nullptr;
+    Capabilities _peer;
+    uint32_t _baudRate = I2C_OVER_UART_BAUD_RATE;   // last confirmed baud rate
+    uint32_t _baudRatePending = 0;                  // waiting for confirmation
+    uint32_t _baudRateSwitched = 0;
+    uint32_t _baudRatePrevious = 0;                 // reverted to if nothing is received after CONFIRMED
+    NegotiationType _negotiationReceived = NegotiationType::NONE;
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    FlowStats _flowStats;
+    uint16_t _flowCredits = kFlowWindow;            // bytes the other side can receive
+    uint16_t _flowConsumed = 0;                     // bytes received and not reported yet
+    uint16_t _flowLineLength = 0;
+    uint32_t _flowLastReceived = 0;
+#endif
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+    SerialTwoWireCompression _decoder;
+    CompressionStats _compressionStats;
+#endif
+#if I2C_OVER_UART_ENABLE_FEC
+    SerialTwoWireFec _fecEncoder;
+    SerialTwoWireFec::Stats _fecStats;
+    uint8_t _fecBuffer[kFecBufferSize];
+    uint8_t _fecLength = 0;
+#if I2C_OVER_UART_ADD_CRC16
+    checksum_t _fecChecksum = 0;                    // received checksum, verified after the correction
+#endif
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    SerialTwoWireRetransmit _retransmit;
+    SequenceStats _sequenceStats;
+    uint8_t _sequenceSession = 0;                   // session of the other side
+    uint8_t _sequenceNext = 0;                      // next expected sequence number
+    bool _sequenceSynced = false;
+#endif
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+    CommandHandler_t _commandHandlers[kCommandHandlers] = {};
+    onUnknownLineCallback _onUnknownLine = nullptr;
+    uint8_t _commandHandler = 0;                    // handler of the current line
+#endif
+#if I2C_OVER_UART_ENABLE_RESYNC
+    ResyncStats _resyncStats;
+    uint32_t _lastFeed = 0;
+#endif
+#if I2C_OVER_UART_ENABLE_RX_RING
+    SerialTwoWireRing _ring;
+#endif
+#if I2C_OVER_UART_ENABLE_WAITER
+    SerialTwoWireWaiter *_waiter = nullptr;
+#endif
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+    SerialTwoWireRemark _remark;
+    uint8_t _line[kLineBufferSize];
+    uint16_t _lineLength = 0;
+#endif
+
 public:
     void beginTransmission(uint8_t address);
     void beginTransmission(int address);
@@ -337,6 +934,9 @@ public:
 
 protected:
     uint8_t _endTransmission(CommandStringType type, uint8_t stop);
+    // send length bytes of data including the address without waiting for credits. returns
+    // false if the frame has not been written completely
+    bool _printFrame(CommandStringType type, const uint8_t *data, size_t length);
 
 #if DEBUG_SERIALTWOWIRE_ALL_PUBLIC
 public:
@@ -107,6 +107,22 @@ inline void SerialTwoWireSlave::onReadSerial(onReadSerialCallback callback)
     _onReadSerial = callback;
 }
 
+#if I2C_OVER_UART_ENABLE_DEFERRED_RESPONSE
+
+inline void SerialTwoWireSlave::deferResponse(uint16_t retryAfter)
+{
+    __LDBG_assertf(flags()._getOutState() == OutStateType::LOCKED, "outs=%u", flags()._outState);
+    _deferredAddress = _out.charAt(0);
+    _deferredRetryAfter = retryAfter;
+}
+
+inline bool SerialTwoWireSlave::isResponsePending() const
+{
+    return _deferredAddress != kNotInitializedAddress;
+}
+
+#endif
+
 inline size_t SerialTwoWireSlave::write(unsigned long n)
 {
     return write((uint8_t)n);
@@ -127,36 +143,254 @@ inline void SerialTwoWireSlave::_discard()
     flags()._setCommand(CommandType::DISCARD);
 }
 
+inline size_t SerialTwoWireSlave::_write(uint8_t data)
+{
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+    if (_lineLength >= kLineBufferSize) {
+        // the line is written in multiple parts
+        _flushLine();
+    }
+    _line[_lineLength++] = data;
+    return 1;
+#else
+    return _serial->write(data);
+#endif
+}
+
+inline size_t SerialTwoWireSlave::_printCommand(CommandStringType type)
+{
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+    size_t written = 0;
+    for(auto str = getCommandStr(type); str && *str; str++) {
+        written += _write(*str);
+    }
+    return written;
+#else
+    return sendCommandStr(*_serial, type);
+#endif
+}
+
 inline size_t SerialTwoWireSlave::_printHex(uint8_t data)
 {
+#if I2C_OVER_UART_ENABLE_FEC
+    _fecEncoder.update(data);
+#endif
     size_t written = _printNibble(data >> 4);
     return written + _printNibble(data & 0xf);
 }
 
 inline size_t SerialTwoWireSlave::_println()
 {
-    return _serial->write('\n');
+#if I2C_OVER_UART_ENABLE_FEC
+    size_t written = _printFec();
+    written += _write('\n');
+#else
+    size_t written = _write('\n');
+#endif
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+    _flushLine();
+#endif
+    return written;
+}
+
+#if I2C_OVER_UART_ENABLE_FEC
+
+// append the check bytes of the data printed with _printHex()
+inline size_t SerialTwoWireSlave::_printFec()
+{
+    if (_fecEncoder.length() == 0) {
+        return 0;
+    }
+    uint8_t parity = _fecEncoder.getParity();
+    uint8_t weightedSum = _fecEncoder.getWeightedSum();
+    _fecEncoder.begin();
+    size_t written = _printNibble(parity >> 4);
+    written += _printNibble(parity & 0xf);
+    written += _printNibble(weightedSum >> 4);
+    return written + _printNibble(weightedSum & 0xf);
+}
+
+inline const SerialTwoWireFec::Stats &SerialTwoWireSlave::getFecStats() const
+{
+    return _fecStats;
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+
+inline const SerialTwoWireRetransmit::Stats &SerialTwoWireSlave::getRetransmitStats() const
+{
+    return _retransmit.getStats();
+}
+
+inline const SerialTwoWireSlave::SequenceStats &SerialTwoWireSlave::getSequenceStats() const
+{
+    return _sequenceStats;
+}
+
+inline void SerialTwoWireSlave::_pollRetransmit()
+{
+    if (_retransmit.isExpired()) {
+        _retransmitFrames();
+    }
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+
+inline SerialTwoWireRemark &SerialTwoWireSlave::remark()
+{
+    return _remark;
+}
+
+inline void SerialTwoWireSlave::_flushLine()
+{
+    if (_lineLength) {
+        _serial->write(_line, _lineLength);
+        _lineLength = 0;
+    }
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_RX_RING
+
+inline bool SerialTwoWireSlave::feedFromISR(uint8_t data)
+{
+    return _ring.push(data);
+}
+
+inline size_t SerialTwoWireSlave::feedFromISR(const uint8_t *data, size_t length)
+{
+    return _ring.push(data, length);
+}
+
+inline void SerialTwoWireSlave::feed()
+{
+    _ring.drain([this](uint8_t data) {
+        feed(data);
+    });
+}
+
+inline const SerialTwoWireRing::Stats &SerialTwoWireSlave::getRingStats() const
+{
+    return _ring.getStats();
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_COMMAND_HANDLERS
+
+inline void SerialTwoWireSlave::onUnknownLine(onUnknownLineCallback callback)
+{
+    _onUnknownLine = callback;
+}
+
+inline void SerialTwoWireSlave::_invokeOnCommand()
+{
+    auto &handler = _commandHandlers[_commandHandler];
+    if (handler._command && handler._callback) {
+        flags()._readFromOut = false;
+        handler._callback(_in.available());
+        flags()._readFromOut = true;
+    }
+}
+
+inline void SerialTwoWireSlave::_forwardUnknownLine(uint8_t byte)
+{
+    if (flags()._unknownLine && byte != '\r' && _onUnknownLine) {
+        _onUnknownLine(&byte, 1, false);
+    }
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_RESYNC
+
+inline const SerialTwoWireSlave::ResyncStats &SerialTwoWireSlave::getResyncStats() const
+{
+    return _resyncStats;
+}
+
+inline bool SerialTwoWireSlave::_isPartialLine() const
+{
+    return _data._command != CommandType::NONE || _data._length != 0;
+}
+
+inline bool SerialTwoWireSlave::_resync(uint8_t byte)
+{
+    uint32_t now = millis();
+    uint32_t idle = now - _lastFeed;
+    _lastFeed = now;
+    if (!_isPartialLine()) {
+        return false;
+    }
+    // valid lines contain a single '+' at the beginning
+    if (byte == '+') {
+        _resyncStats._headers++;
+    }
+    else if (idle > I2C_OVER_UART_IDLE_TIMEOUT) {
+        _resyncStats._timeouts++;
+    }
+    else {
+        return false;
+    }
+    __LDBG_printf("resync data=%u idle=%u cmd=%s", byte, idle, flags()._getCommandAsString().c_str());
+    _discard();
+    _newLine();
+    return true;
 }
 
+inline void SerialTwoWireSlave::_pollResync()
+{
+    if (_isPartialLine() && (uint32_t)(millis() - _lastFeed) > I2C_OVER_UART_IDLE_TIMEOUT) {
+        __LDBG_printf("resync idle cmd=%s", flags()._getCommandAsString().c_str());
+        _resyncStats._timeouts++;
+        _discard();
+        _newLine();
+    }
+}
+
+#endif
+
 inline size_t SerialTwoWireSlave::_printNibble(uint8_t nibble)
 {
-    return _serial->write(nibble < 0xa ? (nibble + '0') : (nibble + ('a' - 0xa)));
+    return _write(nibble < 0xa ? (nibble + '0') : (nibble + ('a' - 0xa)));
+}
+
+inline uint8_t SerialTwoWireSlave::_parseNibble(uint8_t ch)
+{
+    return ch <= '9' ? ch - '0' : (ch | 0x20) - ('a' - 0xa);
+}
+
+inline uint8_t SerialTwoWireSlave::_parseHex(const uint8_t *str)
+{
+    return (_parseNibble(str[0]) << 4) | _parseNibble(str[1]);
 }
 
 #if I2C_OVER_UART_ADD_CRC16
 
-inline size_t SerialTwoWireSlave::_printHexCrc(uint16_t crc)
+inline size_t SerialTwoWireSlave::_printHexCrc(checksum_t crc)
 {
-    size_t written = _serial->write(kCrcStartChar);
-    // not big endian but for strtoul() ...
-    written += _printHex(crc >> 8);
-    written += _printHex((uint8_t)crc);
+#if I2C_OVER_UART_ENABLE_FEC
+    // the check bytes are not covered by the checksum
+    size_t written = _printFec();
+    written += _write(kCrcStartChar);
+#else
+    size_t written = _write(kCrcStartChar);
+#endif
+    // most significant nibble first
+    for(int8_t shift = (sizeof(crc) * 8) - 4; shift >= 0; shift -= 4) {
+        written += _printNibble((crc >> shift) & 0xf);
+    }
     return written + _println();
 }
 
-inline size_t SerialTwoWireSlave::_printHexUpdateCrc(uint8_t data, uint16_t &crc)
+inline size_t SerialTwoWireSlave::_printHexUpdateCrc(uint8_t data, checksum_t &crc)
 {
-    crc = _crc16_update(crc, data);
+    crc = Checksum::update(crc, data);
     return _printHex(data);
 }
 
@@ -194,11 +428,114 @@ inline void SerialTwoWireSlave::_invokeOnRequest()
 
 inline void SerialTwoWireSlave::_invokeOnReadSerial()
 {
+#if I2C_OVER_UART_ENABLE_RX_RING
+    feed();
+#endif
     if (_onReadSerial) {
         _onReadSerial();
     }
 }
 
+#if I2C_OVER_UART_ENABLE_WAITER
+
+inline void SerialTwoWireSlave::setWaiter(SerialTwoWireWaiter *waiter)
+{
+    _waiter = waiter;
+}
+
+#endif
+
+inline void SerialTwoWireSlave::poll()
+{
+#if I2C_OVER_UART_ENABLE_RX_RING
+    feed();
+#endif
+#if I2C_OVER_UART_ENABLE_SUBSCRIPTIONS
+    _pollSubscriptions();
+#endif
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+    _pollFlowControl();
+#endif
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+    _pollNegotiation();
+#endif
+#if I2C_OVER_UART_ENABLE_RELIABLE_DELIVERY
+    _pollRetransmit();
+#endif
+#if I2C_OVER_UART_ENABLE_RESYNC
+    _pollResync();
+#endif
+#if I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+    _pollRemarks();
+#endif
+}
+
+#if I2C_OVER_UART_ENABLE_NEGOTIATION
+
+inline void SerialTwoWireSlave::onBaudRate(onBaudRateCallback callback)
+{
+    _onBaudRate = callback;
+}
+
+inline void SerialTwoWireSlave::onClock(onClockCallback callback)
+{
+    _onClock = callback;
+}
+
+inline const SerialTwoWireSlave::Capabilities &SerialTwoWireSlave::getPeerCapabilities() const
+{
+    return _peer;
+}
+
+inline uint32_t SerialTwoWireSlave::getBaudRate() const
+{
+    return _baudRate;
+}
+
+inline void SerialTwoWireSlave::_commitBaudRate()
+{
+    _baudRatePrevious = 0;
+}
+
+inline bool SerialTwoWireSlave::_invokeOnBaudRate(uint32_t baudRate)
+{
+    // send pending data with the current baud rate
+    _serial->flush();
+    return _onBaudRate && _onBaudRate(baudRate);
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_FLOW_CONTROL
+
+inline uint16_t SerialTwoWireSlave::getCredits() const
+{
+    return _flowCredits;
+}
+
+inline const SerialTwoWireSlave::FlowStats &SerialTwoWireSlave::getFlowStats() const
+{
+    return _flowStats;
+}
+
+#endif
+
+#if I2C_OVER_UART_ENABLE_COMPRESSION
+
+inline const SerialTwoWireSlave::CompressionStats &SerialTwoWireSlave::getCompressionStats() const
+{
+    return _compressionStats;
+}
+
+inline void SerialTwoWireSlave::_beginCompressed()
+{
+    _decoder.begin();
+    flags()._compressed = true;
+    _compressionStats._received++;
+}
+
+#endif
+
 inline Stream *SerialTwoWireSlave::getSerial() const {
     return _serial;
 }
@@ -43,8 +43,8 @@ SerialTwoWireStream::size_type SerialTwoWireStream::write(const uint8_t *data, s
 {
 	auto data_len = (size_type)len;
 	size_type required = data_len + _length;
-	if (required >= _size) {
-		if (!resize(required + 1)) {
+	if (required > _size) {
+		if (!resize(required)) {
 			return 0;
 		}
 	}
@@ -73,6 +73,9 @@ SerialTwoWireStream::size_type SerialTwoWireStream::read(uint8_t *data, size_t l
 
 bool SerialTwoWireStream::resize(size_type new_size)
 {
+	if (_allocMinSize == kStaticBuffer) {
+		return new_size <= _size;
+	}
 	auto blockSize = _get_block_size(new_size);
 	if (blockSize != _size) {
 		_size = _resize(blockSize);
@@ -102,6 +105,9 @@ SerialTwoWireStream::size_type SerialTwoWireStream::_get_block_size(size_type ne
 
 SerialTwoWireStream::size_type SerialTwoWireStream::_resize(size_type new_size)
 {
+	if (_allocMinSize == kStaticBuffer) {
+		return _size;
+	}
 	if (new_size != 0) {
 		if (_buffer) {
 			_buffer = (uint8_t *)realloc(_buffer, new_size);
@@ -40,6 +40,9 @@ public:
     static constexpr size_type kAllocBlockSize = I2C_OVER_UART_ALLOC_BLOCK_SIZE;
     static constexpr size_type kAllocBlockBitMask = __constexpr_is_bitmask(kAllocBlockSize) ? (kAllocBlockSize - 1) : 0;
 
+    // _allocMinSize marker for buffers set with setBuffer()
+    static constexpr size_type kStaticBuffer = ~0;
+
     static constexpr size_type kBitsSize = sizeof(size_type) * 8;
     static constexpr size_type kBitsMinAlloc = kBitsSize;
 
@@ -55,6 +58,10 @@ public:
     // set to kMinAllocNoRealloc to disable changing buffer size
     void setAllocMinSize(uint8_t size);
 
+    // use a fixed buffer instead of allocating memory. the stream cannot grow beyond size
+    // and release() keeps the buffer
+    void setBuffer(uint8_t *buffer, size_type size);
+
     void clear();
     void release();
 
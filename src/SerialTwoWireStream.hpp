@@ -47,7 +47,21 @@ inline SerialTwoWireStream::~SerialTwoWireStream()
 
 inline void SerialTwoWireStream::setAllocMinSize(uint8_t size)
 {
-	_allocMinSize = size;
+	if (_allocMinSize != kStaticBuffer) {
+		_allocMinSize = size;
+	}
+}
+
+inline void SerialTwoWireStream::setBuffer(uint8_t *buffer, size_type size)
+{
+	if (_allocMinSize != kStaticBuffer) {
+		release();
+	}
+	_buffer = buffer;
+	_size = size;
+	_length = 0;
+	_position = 0;
+	_allocMinSize = kStaticBuffer;
 }
 
 inline SerialTwoWireStream::size_type SerialTwoWireStream::_get_alloc_min_size() const {
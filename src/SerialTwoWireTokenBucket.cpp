@@ -0,0 +1,45 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWireTokenBucket.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_QUEUE || I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+
+void SerialTwoWireTokenBucket::setRateLimit(uint16_t rate, uint16_t burst)
+{
+    _rate = rate;
+    _burst = burst ? burst : 1;
+    _tokens = _burst * 1000UL;
+    _lastUpdate = millis();
+}
+
+bool SerialTwoWireTokenBucket::isAllowed(uint16_t length, uint32_t now)
+{
+    if (!_rate) {
+        return true;
+    }
+    // refill the bucket with rate * 1000 tokens per second
+    uint32_t elapsed = now - _lastUpdate;
+    _lastUpdate = now;
+    uint32_t max = _burst * 1000UL;
+    if (elapsed >= (max - _tokens) / _rate + 1) {
+        _tokens = max;
+    }
+    else {
+        _tokens += elapsed * _rate;
+    }
+    return _tokens >= (length < _burst ? length : _burst) * 1000UL;
+}
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,51 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+using namespace SerialTwoWireDef;
+
+#if I2C_OVER_UART_ENABLE_QUEUE || I2C_OVER_UART_ENABLE_OUTPUT_ARBITER
+
+//
+// Token bucket for rate limits in byte per second
+//
+// the bucket holds up to burst bytes and is refilled with rate bytes per second. tokens are
+// stored in 1/1000 byte to refill the bucket every millisecond without rounding errors
+//
+class SerialTwoWireTokenBucket {
+public:
+    SerialTwoWireTokenBucket();
+
+    // rate 0 removes the limit
+    void setRateLimit(uint16_t rate, uint16_t burst);
+    bool isLimited() const;
+
+    // returns true if length bytes can be sent. lengths larger than the bucket are allowed
+    // when it is full
+    bool isAllowed(uint16_t length, uint32_t now);
+    // remove the tokens for length bytes that have been sent
+    void consume(uint16_t length);
+
+private:
+    uint16_t _rate;                             // byte per second, 0 = unlimited
+    uint16_t _burst;                            // bucket size in byte
+    uint32_t _tokens;                           // 1/1000 byte
+    uint32_t _lastUpdate;
+};
+
+#include "SerialTwoWireTokenBucket.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
@@ -0,0 +1,37 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireTokenBucket.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+inline SerialTwoWireTokenBucket::SerialTwoWireTokenBucket() :
+    _rate(0),
+    _burst(0),
+    _tokens(0),
+    _lastUpdate(0)
+{
+}
+
+inline bool SerialTwoWireTokenBucket::isLimited() const
+{
+    return _rate != 0;
+}
+
+inline void SerialTwoWireTokenBucket::consume(uint16_t length)
+{
+    if (_rate) {
+        uint32_t cost = length * 1000UL;
+        _tokens = _tokens > cost ? _tokens - cost : 0;
+    }
+}
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
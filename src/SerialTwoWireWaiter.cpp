@@ -0,0 +1,69 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#include "SerialTwoWireWaiter.h"
+#include "SerialTwoWireDebug.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if I2C_OVER_UART_ENABLE_WAITER && SERIALTWOWIRE_HAVE_POSIX
+
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+SerialTwoWirePollWaiter::SerialTwoWirePollWaiter(int fd) :
+    _fd(fd),
+    _pipe{-1, -1}
+{
+    if (::pipe(_pipe) == 0) {
+        for(auto pipeFd: _pipe) {
+            ::fcntl(pipeFd, F_SETFL, ::fcntl(pipeFd, F_GETFL) | O_NONBLOCK);
+            ::fcntl(pipeFd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+    else {
+        __LDBG_printf("pipe errno=%d", errno);
+        _pipe[0] = -1;
+        _pipe[1] = -1;
+    }
+}
+
+SerialTwoWirePollWaiter::~SerialTwoWirePollWaiter()
+{
+    for(auto pipeFd: _pipe) {
+        if (pipeFd != -1) {
+            ::close(pipeFd);
+        }
+    }
+}
+
+void SerialTwoWirePollWaiter::wait(uint32_t timeout)
+{
+    // negative fds are ignored by poll()
+    struct pollfd fds[2] = {
+        { _fd, POLLIN, 0 },
+        { _pipe[0], POLLIN, 0 }
+    };
+    if (::poll(fds, 2, (int)timeout) > 0 && (fds[1].revents & POLLIN)) {
+        uint8_t buf[16];
+        while (::read(_pipe[0], buf, sizeof(buf)) > 0) {
+        }
+    }
+}
+
+void SerialTwoWirePollWaiter::notify()
+{
+    if (_pipe[1] != -1) {
+        uint8_t data = 0;
+        // a full pipe wakes up wait() anyway
+        (void)!::write(_pipe[1], &data, 1);
+    }
+}
+
+#endif
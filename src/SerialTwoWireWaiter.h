@@ -0,0 +1,73 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireDef.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+using namespace SerialTwoWireDef;
+
+#if I2C_OVER_UART_ENABLE_WAITER
+
+//
+// Wait strategy for blocking calls of the master
+//
+// requestFrom(), endTransmission() and the other blocking methods wait for data by calling
+// wait() and the onReadSerial callback in a loop until the data has been received or the
+// timeout has passed. without a waiter, the loop calls optimistic_yield() and keeps the CPU
+// busy
+//
+// wait() returns if data might be available or after timeout milliseconds. returning early
+// is always allowed
+//
+class SerialTwoWireWaiter {
+public:
+    virtual ~SerialTwoWireWaiter() {}
+
+    virtual void wait(uint32_t timeout) = 0;
+};
+
+#if SERIALTWOWIRE_HAVE_POSIX
+
+//
+// Waiter for hosts with POSIX file descriptors
+//
+// blocks in poll() until the file descriptor of the serial port is readable or notify() has
+// been called. notify() can be used from another thread or a signal handler after storing
+// data with feedFromISR() or to wait for a stream without file descriptor
+//
+class SerialTwoWirePollWaiter : public SerialTwoWireWaiter {
+public:
+    // fd of the serial port, -1 to wait for notify() only
+    SerialTwoWirePollWaiter(int fd = -1);
+    virtual ~SerialTwoWirePollWaiter();
+
+    SerialTwoWirePollWaiter(const SerialTwoWirePollWaiter &) = delete;
+    SerialTwoWirePollWaiter &operator=(const SerialTwoWirePollWaiter &) = delete;
+
+    void setFd(int fd);
+    int getFd() const;
+
+    virtual void wait(uint32_t timeout) override;
+    void notify();
+
+private:
+    int _fd;
+    int _pipe[2];                               // self-pipe for notify()
+};
+
+#endif
+
+#include "SerialTwoWireWaiter.hpp"
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif
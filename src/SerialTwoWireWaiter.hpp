@@ -0,0 +1,30 @@
+/**
+ * Author: sascha_lammers@gmx.de
+ */
+
+#pragma once
+
+#include "SerialTwoWireWaiter.h"
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper.h>
+#include <debug_helper_enable.h>
+#endif
+
+#if SERIALTWOWIRE_HAVE_POSIX
+
+inline void SerialTwoWirePollWaiter::setFd(int fd)
+{
+    _fd = fd;
+}
+
+inline int SerialTwoWirePollWaiter::getFd() const
+{
+    return _fd;
+}
+
+#endif
+
+#if DEBUG_SERIALTWOWIRE
+#include <debug_helper_disable.h>
+#endif